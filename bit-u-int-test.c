@@ -27,9 +27,9 @@ void Check(int condition, char* message) {
 }
 
 void CheckBitUInt(char* expected, BitUInt* this, char* message) {
-  char buffer[100];
-  BitUIntStore(this, 100, buffer);
-  Check(0 == strncmp(expected, buffer, 100), message);
+  char buffer[MAX_NUM_BIT_U_INT_BITS + 1];
+  BitUIntStore(this, MAX_NUM_BIT_U_INT_BITS + 1, buffer);
+  Check(0 == strncmp(expected, buffer, MAX_NUM_BIT_U_INT_BITS + 1), message);
 }
 
 void TestLoadAndStore() {
@@ -37,23 +37,23 @@ void TestLoadAndStore() {
 
   char* example = "0101";
   BitUIntLoad(strlen(example), example, &a);
-  Check(a.bits[0] == 0, "loaded bit 0 should be 0");
-  Check(a.bits[1] == 1, "loaded bit 1 should be 1");
-  Check(a.bits[2] == 0, "loaded bit 2 should be 0");
-  Check(a.bits[3] == 1, "loaded bit 3 should be 1");
+  Check(BitUIntGetBit(0, &a) == 0, "loaded bit 0 should be 0");
+  Check(BitUIntGetBit(1, &a) == 1, "loaded bit 1 should be 1");
+  Check(BitUIntGetBit(2, &a) == 0, "loaded bit 2 should be 0");
+  Check(BitUIntGetBit(3, &a) == 1, "loaded bit 3 should be 1");
   Check(a.num_bits == 4, "loaded num bits should be 4");
 
   example = "10121001";
   BitUIntLoad(strlen(example), example, &a);
-  Check(a.bits[0] == 1, "loaded bit 0 should be 1");
-  Check(a.bits[1] == 0, "loaded bit 1 should be 0");
-  Check(a.bits[3] == 1, "loaded bit 2 should be 1");
+  Check(BitUIntGetBit(0, &a) == 1, "loaded bit 0 should be 1");
+  Check(BitUIntGetBit(1, &a) == 0, "loaded bit 1 should be 0");
+  Check(BitUIntGetBit(2, &a) == 1, "loaded bit 2 should be 1");
   Check(a.num_bits == 3, "loaded num bits should be 3");
 
   example = "010000";
   BitUIntLoad(strlen(example), example, &a);
-  Check(a.bits[0] == 0, "load and trim bit 0 should be 0");
-  Check(a.bits[1] == 1, "load and trim bit 1 should be 1");
+  Check(BitUIntGetBit(0, &a) == 0, "load and trim bit 0 should be 0");
+  Check(BitUIntGetBit(1, &a) == 1, "load and trim bit 1 should be 1");
   Check(a.num_bits == 2, "loaded num bits should be 2");
 
   char buffer[30];
@@ -70,11 +70,11 @@ void TestClone() {
   char* example = "11101";
   BitUIntLoad(strlen(example), example, &a);
   BitUIntClone(&a, &b);
-  Check(b.bits[0] == 1, "clone bit 0 should be 1");
-  Check(b.bits[1] == 1, "clone bit 1 should be 1");
-  Check(b.bits[2] == 1, "clone bit 2 should be 1");
-  Check(b.bits[3] == 0, "clone bit 3 should be 0");
-  Check(b.bits[4] == 1, "clone bit 4 should be 1");
+  Check(BitUIntGetBit(0, &b) == 1, "clone bit 0 should be 1");
+  Check(BitUIntGetBit(1, &b) == 1, "clone bit 1 should be 1");
+  Check(BitUIntGetBit(2, &b) == 1, "clone bit 2 should be 1");
+  Check(BitUIntGetBit(3, &b) == 0, "clone bit 3 should be 0");
+  Check(BitUIntGetBit(4, &b) == 1, "clone bit 4 should be 1");
   Check(b.num_bits == 5, "cloned num bits should be 5");
 }
 
@@ -289,6 +289,29 @@ void TestDivide() {
   BitUIntDiv(&n, &d, &q, &r);
   CheckBitUInt("11001", &q, "1777 divided by 93 should be 19");
   CheckBitUInt("0101", &r, "1777 divided by 93 should have a remainder of 10");
+
+  // 3^120 + 12345 by 2^70 + 3 and by 1,000,000,007, which take the multiple
+  // word and single word paths.
+  n_str = "010110010010111001110111000011011101011100111111000011110000"
+          "011000001101110110100111000111011011010000100111100010001101"
+          "100100011110001110101000111111011001100101101101100101011001"
+          "00101001001";
+  d_str = "110000000000000000000000000000000000000000000000000000000000"
+          "00000000001";
+  BitUIntLoad(strlen(n_str), n_str, &n);
+  BitUIntLoad(strlen(d_str), d_str, &d);
+  BitUIntDiv(&n, &d, &q, &r);
+  CheckBitUInt("010110011010011010001100100111001001010101100000100110000111"
+               "1000111010100011111101100110010110110110010101100100101001001",
+               &q, "Quotient of 3^120 + 12345 by 2^70 + 3");
+  CheckBitUInt("001100111100001001011010101000000000111100010111101001010110"
+               "0000110101", &r, "Remainder of 3^120 + 12345 by 2^70 + 3");
+
+  d_str = "111000000101001101011001110111";
+  BitUIntLoad(strlen(d_str), d_str, &d);
+  BitUIntMod(&n, &d, &r);
+  CheckBitUInt("010011011100001100101000111011", &r,
+               "Remainder of 3^120 + 12345 by 1,000,000,007");
 }
 
 void TestMod() {
@@ -348,6 +371,23 @@ void TestBase10Store() {
   BitUIntBase10Store(&a, 9, dec_str);
   Check(0 == strncmp(dec_str, "11923", 9),
         "11001001011101 should be 11923 in base 10");
+
+  // Values which span more than one 19 digit chunk, including chunks which
+  // are all zeroes.
+  char long_dec_str[BASE_10_BIT_U_INT_BUFFER_SIZE];
+  a_str = "0000000000000000000101111001000100100000110001001110001101010001";
+  BitUIntLoad(strlen(a_str), a_str, &a);
+  BitUIntBase10Store(&a, BASE_10_BIT_U_INT_BUFFER_SIZE, long_dec_str);
+  Check(0 == strcmp(long_dec_str, "10000000000000000000"),
+        "10^19 should be 10000000000000000000 in base 10");
+
+  a_str = "111000000000000000000000000000000000001001000100010100011001000"
+          "0010111100010001101100001010110100001010100110010110111001101001";
+  BitUIntLoad(strlen(a_str), a_str, &a);
+  BitUIntBase10Store(&a, BASE_10_BIT_U_INT_BUFFER_SIZE, long_dec_str);
+  Check(0 == strcmp(long_dec_str,
+                    "100000000000000000000000000000000000007"),
+        "10^38 + 7 should be 100000000000000000000000000000000000007");
 }
 
 void TestApproximateSquareRoot() {
@@ -395,6 +435,38 @@ void TestApproximateSquareRoot() {
                "Root of 1,934,725,265,902,145 should be 43,985,513");
 }
 
+void TestIsqrt() {
+  BitUInt n, root, stepped_root;
+  char* n_str;
+
+  // 210 is just below 15 squared.
+  n_str = "01001011";
+  BitUIntLoad(strlen(n_str), n_str, &n);
+  BitUIntIsqrt(&n, &root);
+  CheckBitUInt("0111", &root, "Integer root of 210 should be 14");
+  BitUIntApproximateSquareRoot(&n, &root);
+  CheckBitUInt("1111", &root, "Approximate root of 210 should be 15");
+
+  n_str = "1";
+  BitUIntLoad(strlen(n_str), n_str, &n);
+  BitUIntIsqrt(&n, &root);
+  CheckBitUInt("1", &root, "Integer root of 1 should be 1");
+
+  // Step the root from 1 up across the perfect squares 4, 9 and 16.
+  BitUIntClone(&root, &stepped_root);
+  n_str = "00001";
+  BitUIntLoad(strlen(n_str), n_str, &n);
+  BitUIntIsqrtUpdate(&n, &stepped_root);
+  CheckBitUInt("001", &stepped_root, "Updated root of 16 should be 4");
+  BitUIntIsqrt(&n, &root);
+  CheckBitUInt("001", &root, "Integer root of 16 should be 4");
+
+  n_str = "11110";
+  BitUIntLoad(strlen(n_str), n_str, &n);
+  BitUIntIsqrt(&n, &root);
+  CheckBitUInt("11", &root, "Integer root of 15 should be 3");
+}
+
 
 int main() {
   TestLoadAndStore();
@@ -410,5 +482,6 @@ int main() {
   TestMod();
   TestBase10Store();
   TestApproximateSquareRoot();
+  TestIsqrt();
   printf("All tests passed\n");
 }
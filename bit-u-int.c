@@ -20,10 +20,116 @@
 #include <stdio.h>
 #include <string.h>
 
+// The number of words needed to hold num_bits bits.
+static int NumWords(int num_bits) {
+  return (num_bits + 63) / 64;
+}
+
+// Reads a word of the value. Bits at or above num_bits are treated as zero
+// whatever the words hold there.
+static uint64_t WordAt(int index, const BitUInt* this) {
+  int bits_in_word = this->num_bits - 64 * index;
+  if (bits_in_word <= 0) {
+    return 0;
+  }
+  if (bits_in_word >= 64) {
+    return this->words[index];
+  }
+  return this->words[index] & (((uint64_t)1 << bits_in_word) - 1);
+}
+
+// Copies the value out in to a full set of words.
+static void GetWords(const BitUInt* this, uint64_t* words) {
+  int i;
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    words[i] = WordAt(i, this);
+  }
+}
+
+// Stores a full set of words as the value with num_bits bits in use, clearing
+// anything above num_bits in the top word.
+static void SetWords(const uint64_t* words, int num_bits, BitUInt* this) {
+  assert(num_bits >= 0 && num_bits <= MAX_NUM_BIT_U_INT_BITS);
+  this->num_bits = num_bits;
+  int num_words = NumWords(num_bits);
+  int i;
+  for (i = 0; i < num_words; i++) {
+    this->words[i] = words[i];
+  }
+  if (num_bits % 64 != 0) {
+    this->words[num_words - 1] &= ((uint64_t)1 << (num_bits % 64)) - 1;
+  }
+}
+
+// Counts the bits up to and including the highest set bit.
+static int BitLength(const uint64_t* words, int num_words) {
+  while (num_words > 0 && words[num_words - 1] == 0) {
+    num_words--;
+  }
+  if (num_words == 0) {
+    return 0;
+  }
+  return 64 * num_words - __builtin_clzll(words[num_words - 1]);
+}
+
+// Counts the bits in the value up to and including the highest set bit,
+// which is num_bits when there are no leading zeros.
+static int ValueBitLength(const BitUInt* this) {
+  int i;
+  for (i = NumWords(this->num_bits) - 1; i >= 0; i--) {
+    uint64_t word = WordAt(i, this);
+    if (word != 0) {
+      return 64 * i + 64 - __builtin_clzll(word);
+    }
+  }
+  return 0;
+}
+
+static int Max(int a, int b) {
+  return a > b ? a : b;
+}
+
+// Moves the bits in the low num_words words up, dropping any which pass the
+// top of them.
+static void ShiftWordsUp(int num_bits, uint64_t* words, int num_words) {
+  int word_shift = num_bits / 64;
+  int bit_shift = num_bits % 64;
+  int i;
+  for (i = num_words - 1; i >= 0; i--) {
+    int source = i - word_shift;
+    uint64_t word = 0;
+    if (source >= 0) {
+      word = words[source] << bit_shift;
+      if (bit_shift > 0 && source > 0) {
+        word |= words[source - 1] >> (64 - bit_shift);
+      }
+    }
+    words[i] = word;
+  }
+}
+
+// Moves the bits in the low num_words words down, dropping the low bits.
+static void ShiftWordsDown(int num_bits, uint64_t* words, int num_words) {
+  int word_shift = num_bits / 64;
+  int bit_shift = num_bits % 64;
+  int i;
+  for (i = 0; i < num_words; i++) {
+    int source = i + word_shift;
+    uint64_t word = 0;
+    if (source < num_words) {
+      word = words[source] >> bit_shift;
+      if (bit_shift > 0 && source + 1 < num_words) {
+        word |= words[source + 1] << (64 - bit_shift);
+      }
+    }
+    words[i] = word;
+  }
+}
+
 void BitUIntPrint(const BitUInt* this) {
   int i;
   for (i = 0; i < this->num_bits; i++) {
-    printf("%i", this->bits[i]);
+    printf("%i", BitUIntGetBit(i, this));
   }
 }
 
@@ -37,11 +143,12 @@ void BitUIntLoad(int buffer_size, char* buffer, BitUInt* this) {
   int i;
   char current;
   this->num_bits = 0;
+  memset(this->words, 0, sizeof(this->words));
   for (i = 0; i < buffer_size; i++) {
-    assert(i < MAX_NUM_BIT_U_INT_BITS);
     current = buffer[i];
     if (current == '0' || current == '1') {
-      this->bits[i] = current - '0';
+      assert(i < MAX_NUM_BIT_U_INT_BITS);
+      this->words[i / 64] |= (uint64_t)(current - '0') << (i % 64);
       this->num_bits++;
     } else {
       break;
@@ -54,36 +161,42 @@ void BitUIntStore(const BitUInt* this, int buffer_size, char* buffer) {
   assert(this->num_bits < buffer_size);
   int i;
   for (i = 0; i < this->num_bits; i++) {
-    buffer[i] = this->bits[i] + '0';
+    buffer[i] = BitUIntGetBit(i, this) + '0';
   }
   buffer[i] = 0;
 }
 
+// Decimal digits are found 19 at a time, the most which fit in a 64 bit
+// word, so only a few of the slow bit by bit divisions are needed.
+#define BASE_10_CHUNK_DIGITS 19
+#define BASE_10_CHUNK 10000000000000000000ULL
+
 void BitUIntBase10Store(const BitUInt* this, int buffer_size, char* buffer) {
-  char internal_buffer[BASE_10_BIT_U_INT_BUFFER_SIZE];
+  char internal_buffer[BASE_10_BIT_U_INT_BUFFER_SIZE + BASE_10_CHUNK_DIGITS];
   int num_digits = 0;
-  int i, power;
+  int i;
   BitUInt reduced_this;
   BitUInt quotient;
   BitUInt remainder;
-  BitUInt ten;
-  ten.num_bits = 4;
-  ten.bits[0] = 0;
-  ten.bits[1] = 1;
-  ten.bits[2] = 0;
-  ten.bits[3] = 1;
-
-  BitUIntDiv(this, &ten, &quotient, &remainder);
-  while (remainder.num_bits > 0 || quotient.num_bits > 0) {
-    internal_buffer[num_digits] = 0;
-    power = 1;
-    for (i = 0; i < remainder.num_bits; i++) {
-      internal_buffer[num_digits] += remainder.bits[i] * power;
-      power *= 2;
-    }
+  BitUInt chunk_divisor;
+  BitUIntSetUInt64(BASE_10_CHUNK, &chunk_divisor);
+
+  // Each chunk adds 19 digits, lowest first, except the last which stops at
+  // its highest non zero digit.
+  BitUIntClone(this, &reduced_this);
+  BitUIntTrim(&reduced_this);
+  while (reduced_this.num_bits > 0) {
+    BitUIntDiv(&reduced_this, &chunk_divisor, &quotient, &remainder);
+    uint64_t chunk = BitUIntGetUInt64(&remainder);
     BitUIntClone(&quotient, &reduced_this);
-    num_digits++;
-    BitUIntDiv(&reduced_this, &ten, &quotient, &remainder);
+    for (i = 0; i < BASE_10_CHUNK_DIGITS; i++) {
+      if (reduced_this.num_bits == 0 && chunk == 0) {
+        break;
+      }
+      internal_buffer[num_digits] = chunk % 10;
+      chunk /= 10;
+      num_digits++;
+    }
   }
 
   assert(num_digits < buffer_size - 1);
@@ -94,67 +207,89 @@ void BitUIntBase10Store(const BitUInt* this, int buffer_size, char* buffer) {
   buffer[i] = '\0';
 }
 
+void BitUIntSetUInt64(uint64_t value, BitUInt* this) {
+  uint64_t words[NUM_BIT_U_INT_WORDS] = {value};
+  SetWords(words, BitLength(words, 1), this);
+}
 
-void BitUIntClone(const BitUInt* that, BitUInt* this) {
-  this->num_bits = that->num_bits;
-  int i;
-  for (i = 0; i < that->num_bits; i++) {
-    this->bits[i] = that->bits[i];
+uint64_t BitUIntGetUInt64(const BitUInt* this) {
+  return WordAt(0, this);
+}
+
+int BitUIntGetBit(int index, const BitUInt* this) {
+  assert(index >= 0);
+  return (WordAt(index / 64, this) >> (index % 64)) & 1;
+}
+
+void BitUIntSetBit(int value, int index, BitUInt* this) {
+  assert(index >= 0 && index < this->num_bits);
+  uint64_t mask = (uint64_t)1 << (index % 64);
+  if (value) {
+    this->words[index / 64] |= mask;
+  } else {
+    this->words[index / 64] &= ~mask;
   }
 }
 
+void BitUIntClone(const BitUInt* that, BitUInt* this) {
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(that, words);
+  SetWords(words, that->num_bits, this);
+}
+
 void BitUIntTrim(BitUInt* this) {
-  while (this->num_bits > 0 && this->bits[this->num_bits - 1] == 0) {
-    this->num_bits--;
+  int num_bits = ValueBitLength(this);
+  if (num_bits % 64 != 0) {
+    this->words[num_bits / 64] = WordAt(num_bits / 64, this);
   }
+  this->num_bits = num_bits;
 }
 
 void BitUIntInc(BitUInt* this) {
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(this, words);
   int i;
-  for (i = 0; i < this->num_bits; i++) {
-    if (this->bits[i] == 1) {
-      this->bits[i] = 0;
-    } else {
-      this->bits[i] = 1;
-    	  return;
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    words[i]++;
+    if (words[i] != 0) {
+      break;
     }
   }
-  this->num_bits++;
-  this->bits[i] = 1;
+  // A carry out of the top bit in use adds one more bit.
+  SetWords(words, Max(this->num_bits, BitLength(words, NUM_BIT_U_INT_WORDS)),
+           this);
 }
 
 void BitUIntDec(BitUInt* this) {
   assert(this->num_bits > 0);
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(this, words);
   int i;
-  for (i = 0; i < this->num_bits; i++) {
-    if (this->bits[i] == 1) {
-      this->bits[i] = 0;
-      BitUIntTrim(this);
-      return;
-    } else {
-      this->bits[i] = 1;
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    words[i]--;
+    if (words[i] != UINT64_MAX) {
+      break;
     }
   }
+  SetWords(words, this->num_bits, this);
+  BitUIntTrim(this);
 }
 
 void BitUIntDouble(BitUInt* this) {
   assert(this->num_bits < MAX_NUM_BIT_U_INT_BITS);
-  int i;
-  this->num_bits++;
-  for (i = this->num_bits - 1; i >= 1; i--) {
-    this->bits[i] = this->bits[i - 1];
-  }
-  this->bits[0] = 0;
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(this, words);
+  ShiftWordsUp(1, words, NumWords(this->num_bits + 1));
+  SetWords(words, this->num_bits + 1, this);
 }
 
 int BitUIntHalve(BitUInt* this) {
   if (this->num_bits > 0) {
-    int low_bit = this->bits[0];
-    int i;
-    for (i = 1; i < this->num_bits; i++) {
-      this->bits[i - 1] = this->bits[i];
-    }
-    this->num_bits--;
+    uint64_t words[NUM_BIT_U_INT_WORDS];
+    GetWords(this, words);
+    int low_bit = words[0] & 1;
+    ShiftWordsDown(1, words, NumWords(this->num_bits));
+    SetWords(words, this->num_bits - 1, this);
     return low_bit;
   } else {
     return 0;
@@ -166,193 +301,278 @@ void BitUIntShiftInc(int num_bits, BitUInt* this) {
   if (this->num_bits == 0) {
     return;
   }
-  int i;
-  for (i = this->num_bits - 1; i >= 0; i--) {
-    this->bits[i + num_bits] = this->bits[i];
-  }
-  this->num_bits += num_bits;
-  memset(this->bits, 0, num_bits); 
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(this, words);
+  ShiftWordsUp(num_bits, words, NumWords(this->num_bits + num_bits));
+  SetWords(words, this->num_bits + num_bits, this);
 }
 
 void BitUIntShiftDec(int num_bits, BitUInt* this) {
   assert(this->num_bits - num_bits >= 0);
-  this->num_bits -= num_bits;
-  int i;
-  for (i = 0; i < this->num_bits; i++) {
-    this->bits[i] = this->bits[i + num_bits];
-  }
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  GetWords(this, words);
+  ShiftWordsDown(num_bits, words, NumWords(this->num_bits));
+  SetWords(words, this->num_bits - num_bits, this);
 }
 
 void BitUIntAdd(BitUInt* that, BitUInt* this) {
-  int carry = 0;
-  int sum;
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  uint64_t carry = 0;
   int i;
-  for (i = 0; i < that->num_bits || i < this->num_bits; i++) {
-    if (i < that->num_bits && i < this->num_bits) {
-      sum = this->bits[i] + that->bits[i] + carry;
-      carry = sum > 1;
-      this->bits[i] = sum & 1;
-    } else if (i < that->num_bits) {
-      sum = that->bits[i] + carry;
-      carry = sum > 1;
-      this->bits[i] = sum & 1;
-      this->num_bits++;
-    } else if (i < this->num_bits) {
-      sum = this->bits[i] + carry;
-      carry = sum > 1;
-      this->bits[i] = sum & 1;
-    }
-  }
-  if (carry) {
-    this->bits[i] = 1;
-    this->num_bits++;
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    unsigned __int128 sum =
+        (unsigned __int128)WordAt(i, this) + WordAt(i, that) + carry;
+    words[i] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
   }
+  assert(carry == 0);
+  int num_bits = Max(Max(this->num_bits, that->num_bits),
+                     BitLength(words, NUM_BIT_U_INT_WORDS));
+  SetWords(words, num_bits, this);
 }
 
 void BitUIntSub(const BitUInt* that, BitUInt* this) {
   assert(BitUIntLessThanOrEqual(that, this));
+  uint64_t words[NUM_BIT_U_INT_WORDS];
+  uint64_t borrow = 0;
   int i;
-  int borrow = 0;
-  int diff;
-  for (i = 0; i < that->num_bits || i < this->num_bits; i++) {
-    if (i < that->num_bits && i < this->num_bits) {
-      diff = this->bits[i] - that->bits[i] - borrow;
-      borrow = diff < 0;
-      this->bits[i] = diff & 1;
-    } else if (i < this->num_bits) {
-      diff = this->bits[i] - borrow;
-      borrow = diff < 0;
-      this->bits[i] = diff & 1;
-    } 
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    uint64_t a = WordAt(i, this);
+    uint64_t b = WordAt(i, that);
+    words[i] = a - b - borrow;
+    borrow = a < b || (a == b && borrow);
   }
+  SetWords(words, this->num_bits, this);
   BitUIntTrim(this);
 }
 
 void BitUIntMul(const BitUInt* that, BitUInt* this) {
-  if (0 == that->num_bits) {
-    this->num_bits = 0;
+  uint64_t product[2 * NUM_BIT_U_INT_WORDS] = {0};
+  int i, j;
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    uint64_t a = WordAt(i, that);
+    if (a == 0) {
+      continue;
+    }
+    uint64_t carry = 0;
+    for (j = 0; j < NUM_BIT_U_INT_WORDS; j++) {
+      unsigned __int128 value =
+          (unsigned __int128)a * WordAt(j, this) + product[i + j] + carry;
+      product[i + j] = (uint64_t)value;
+      carry = (uint64_t)(value >> 64);
+    }
+    product[i + NUM_BIT_U_INT_WORDS] = carry;
   }
+  SetWords(product, BitLength(product, 2 * NUM_BIT_U_INT_WORDS), this);
+}
 
-  BitUInt original_this;
-  BitUIntClone(this, &original_this);
+// Compares the low num_words words of a and b, using the same return values
+// as BitUIntCompare.
+static int CompareWords(const uint64_t* a, const uint64_t* b, int num_words) {
   int i;
-  // Step backwards through that, adding where there is a 1 and shifting for
-  // each position.
-  for (i = that->num_bits - 2; i >= 0; i--) {
-    BitUIntDouble(this);
-    if (that->bits[i]) {
-      BitUIntAdd(&original_this, this);
+  for (i = num_words - 1; i >= 0; i--) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? 1 : -1;
     }
   }
+  return 0;
 }
 
-void BitUIntDiv(const BitUInt* numerator, const BitUInt* denominator,
-                BitUInt* quotient, BitUInt* remainder) {
-  assert(denominator->num_bits > 0);
+// Subtracts b from a in the low num_words words, where a is at least b.
+static void SubWords(const uint64_t* b, uint64_t* a, int num_words) {
+  uint64_t borrow = 0;
+  int i;
+  for (i = 0; i < num_words; i++) {
+    uint64_t a_word = a[i];
+    a[i] = a_word - b[i] - borrow;
+    borrow = a_word < b[i] || (a_word == b[i] && borrow);
+  }
+}
 
-  BitUIntClone(numerator, remainder);
-  if (BitUIntLessThan(numerator, denominator)) {
-    quotient->num_bits = 0;
-    return;
+// Divides one full set of words by another in a single pass, storing the
+// remainder and, unless quotient is NULL, the quotient. The denominator must
+// not be zero.
+static void DivideWords(const uint64_t* numerator,
+                        const uint64_t* denominator,
+                        uint64_t* quotient, uint64_t* remainder) {
+  int numerator_bits = BitLength(numerator, NUM_BIT_U_INT_WORDS);
+  int denominator_bits = BitLength(denominator, NUM_BIT_U_INT_WORDS);
+  int num_words = NumWords(numerator_bits);
+  uint64_t quotient_words[NUM_BIT_U_INT_WORDS] = {0};
+  uint64_t remainder_words[NUM_BIT_U_INT_WORDS] = {0};
+  int i;
+
+  if (denominator_bits <= 64) {
+    // A word sized divisor takes one hardware division per word, carrying
+    // the remainder down.
+    uint64_t divisor = denominator[0];
+    uint64_t carry = 0;
+    if (num_words <= 1) {
+      quotient_words[0] = numerator[0] / divisor;
+      carry = numerator[0] % divisor;
+    }
+    for (i = num_words - 1; i >= 0 && num_words > 1; i--) {
+      unsigned __int128 current =
+          ((unsigned __int128)carry << 64) | numerator[i];
+      if (quotient != NULL) {
+        quotient_words[i] = (uint64_t)(current / divisor);
+      }
+      carry = (uint64_t)(current % divisor);
+    }
+    remainder_words[0] = carry;
+  } else {
+    // Line the divisor up with the top of the remainder and walk it down,
+    // subtracting where it fits. After each step the remainder's bit length
+    // shows how far the divisor can drop before it could fit again, so runs
+    // of zero quotient bits are skipped in one shift.
+    for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+      remainder_words[i] = numerator[i];
+    }
+    int shift = numerator_bits - denominator_bits;
+    int remainder_bits = numerator_bits;
+    uint64_t shifted[NUM_BIT_U_INT_WORDS];
+    for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+      shifted[i] = denominator[i];
+    }
+    if (shift >= 0) {
+      ShiftWordsUp(shift, shifted, num_words);
+    }
+    while (shift >= 0) {
+      if (CompareWords(remainder_words, shifted, num_words) < 1) {
+        SubWords(shifted, remainder_words, num_words);
+        quotient_words[shift / 64] |= (uint64_t)1 << (shift % 64);
+        remainder_bits = BitLength(remainder_words, num_words);
+      }
+      int next_shift = remainder_bits - denominator_bits;
+      if (next_shift > shift - 1) {
+        next_shift = shift - 1;
+      }
+      if (next_shift < 0) {
+        break;
+      }
+      ShiftWordsDown(shift - next_shift, shifted, num_words);
+      shift = next_shift;
+    }
   }
 
-  BitUInt multiplied_denominator;
-  BitUIntClone(denominator, &multiplied_denominator);
-  int num_shifts;
-  quotient->num_bits = remainder->num_bits - multiplied_denominator.num_bits + 1;
-  memset(quotient->bits, 0, quotient->num_bits);
-  while (BitUIntLessThanOrEqual(denominator, remainder)) {
-    num_shifts = remainder->num_bits - multiplied_denominator.num_bits;
-    BitUIntShiftInc(num_shifts, &multiplied_denominator);
-    if (BitUIntLessThan(remainder, &multiplied_denominator)) {
-      num_shifts--;
-      BitUIntHalve(&multiplied_denominator);
+  if (quotient != NULL) {
+    for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+      quotient[i] = quotient_words[i];
     }
-    BitUIntSub(&multiplied_denominator, remainder);
-    quotient->bits[num_shifts] = 1;
-    BitUIntClone(denominator, &multiplied_denominator);
   }
+  for (i = 0; i < NUM_BIT_U_INT_WORDS; i++) {
+    remainder[i] = remainder_words[i];
+  }
+}
 
-  BitUIntTrim(quotient); 
+void BitUIntDiv(const BitUInt* numerator, const BitUInt* denominator,
+                BitUInt* quotient, BitUInt* remainder) {
+  uint64_t numerator_words[NUM_BIT_U_INT_WORDS];
+  uint64_t denominator_words[NUM_BIT_U_INT_WORDS];
+  uint64_t quotient_words[NUM_BIT_U_INT_WORDS];
+  uint64_t remainder_words[NUM_BIT_U_INT_WORDS];
+  GetWords(numerator, numerator_words);
+  GetWords(denominator, denominator_words);
+  assert(BitLength(denominator_words, NUM_BIT_U_INT_WORDS) > 0);
+
+  DivideWords(numerator_words, denominator_words, quotient_words,
+              remainder_words);
+  SetWords(quotient_words, BitLength(quotient_words, NUM_BIT_U_INT_WORDS),
+           quotient);
+  SetWords(remainder_words, BitLength(remainder_words, NUM_BIT_U_INT_WORDS),
+           remainder);
 }
 
 void BitUIntMod(const BitUInt* numerator, const BitUInt* denominator,
                 BitUInt* remainder) {
-  assert(denominator->num_bits > 0);
-  BitUIntClone(numerator, remainder);
-  if (BitUIntLessThan(numerator, denominator)) {
-    return;
-  }
-
-  BitUInt multiplied_denominator;
-  BitUIntClone(denominator, &multiplied_denominator);
-  int num_shifts;
-  while (BitUIntLessThanOrEqual(denominator, remainder)) {
-    num_shifts = remainder->num_bits - multiplied_denominator.num_bits;
-    BitUIntShiftInc(num_shifts, &multiplied_denominator);
-    if (BitUIntLessThan(remainder, &multiplied_denominator)) {
-      num_shifts--;
-      BitUIntHalve(&multiplied_denominator);
-    }
-    BitUIntSub(&multiplied_denominator, remainder);
-    BitUIntClone(denominator, &multiplied_denominator);
-  }
+  uint64_t numerator_words[NUM_BIT_U_INT_WORDS];
+  uint64_t denominator_words[NUM_BIT_U_INT_WORDS];
+  uint64_t remainder_words[NUM_BIT_U_INT_WORDS];
+  GetWords(numerator, numerator_words);
+  GetWords(denominator, denominator_words);
+  assert(BitLength(denominator_words, NUM_BIT_U_INT_WORDS) > 0);
+
+  DivideWords(numerator_words, denominator_words, NULL, remainder_words);
+  SetWords(remainder_words, BitLength(remainder_words, NUM_BIT_U_INT_WORDS),
+           remainder);
 }
 
-void BitUIntApproximateSquareRoot(const BitUInt* this, BitUInt* root) {
-  BitUInt two;
-  two.num_bits = 2;
-  two.bits[0] = 0;
-  two.bits[1] = 1;
+void BitUIntIsqrt(const BitUInt* this, BitUInt* root) {
+  BitUInt n;
+  BitUIntClone(this, &n);
+  BitUIntTrim(&n);
+  if (n.num_bits == 0) {
+    root->num_bits = 0;
+    return;
+  }
 
-  BitUInt remainder;
+  // Start from 2^ceil(num_bits / 2) which is at least the square root, then
+  // let Newton's iteration fall until it stops decreasing.
   BitUInt estimate;
-  // Start by using an estimate of just above half of the input.
-  BitUIntDiv(this, &two, &estimate, &remainder);
-  BitUIntInc(&estimate);
+  int exponent = (n.num_bits + 1) / 2;
+  BitUIntSetUInt64(1, &estimate);
+  BitUIntShiftInc(exponent, &estimate);
 
-  BitUInt quotient;
   BitUInt next_estimate;
-  next_estimate.num_bits = 0;
-
-  int divided_evenly = 0;
-  int comparison;
+  BitUInt remainder;
   while (1) {
-    BitUIntDiv(this, &estimate, &quotient, &remainder);
-    if (remainder.num_bits == 0) {
-      divided_evenly = 1;
-    } else {
-      divided_evenly = 0;
-    }
-    BitUIntAdd(&estimate, &quotient);
-    BitUIntDiv(&quotient, &two, &next_estimate, &remainder);
-
-    comparison = BitUIntCompare(&next_estimate, &estimate);
-    if (comparison < 1) {
-      if (comparison < 0) {
-        divided_evenly = 0;
-      }
+    BitUIntDiv(&n, &estimate, &next_estimate, &remainder);
+    BitUIntAdd(&estimate, &next_estimate);
+    BitUIntHalve(&next_estimate);
+    if (!BitUIntLessThan(&next_estimate, &estimate)) {
       break;
     }
-
     BitUIntClone(&next_estimate, &estimate);
   }
 
   BitUIntClone(&estimate, root);
-  if (divided_evenly == 0) {
-    BitUIntInc(root);
+}
+
+void BitUIntIsqrtUpdate(const BitUInt* this, BitUInt* root) {
+  BitUInt n;
+  BitUIntClone(this, &n);
+  BitUIntTrim(&n);
+
+  BitUInt next_root;
+  BitUInt square;
+  BitUIntClone(root, &next_root);
+  BitUIntInc(&next_root);
+  BitUIntClone(&next_root, &square);
+  BitUIntMul(&next_root, &square);
+  BitUIntTrim(&square);
+  while (BitUIntLessThanOrEqual(&square, &n)) {
+    BitUIntClone(&next_root, root);
+    BitUIntInc(&next_root);
+    BitUIntClone(&next_root, &square);
+    BitUIntMul(&next_root, &square);
+    BitUIntTrim(&square);
   }
 }
 
-int BitUIntCompare(const BitUInt* this, const BitUInt* that) {
-  if (this->num_bits != that->num_bits) {
-    return this->num_bits < that->num_bits ? 1 : -1;
+void BitUIntApproximateSquareRoot(const BitUInt* this, BitUInt* root) {
+  BitUInt n;
+  BitUIntClone(this, &n);
+  BitUIntTrim(&n);
+
+  BitUIntIsqrt(&n, root);
+  BitUInt square;
+  BitUIntClone(root, &square);
+  BitUIntMul(root, &square);
+  BitUIntTrim(&square);
+  if (!BitUIntEqual(&square, &n)) {
+    BitUIntInc(root);
   }
+}
 
+int BitUIntCompare(const BitUInt* this, const BitUInt* that) {
+  // Leading zeros may differ, so the words are compared from the top of the
+  // longer of the two.
   int i;
-  for (i = this->num_bits - 1; i >= 0; i--) {
-    if (this->bits[i] != that->bits[i]) {
-      return this->bits[i] < that->bits[i] ? 1 : -1;
+  for (i = NumWords(Max(this->num_bits, that->num_bits)) - 1; i >= 0; i--) {
+    uint64_t this_word = WordAt(i, this);
+    uint64_t that_word = WordAt(i, that);
+    if (this_word != that_word) {
+      return this_word < that_word ? 1 : -1;
     }
   }
   return 0;
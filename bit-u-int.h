@@ -26,9 +26,14 @@
 // terminator. This should be a safe overestimate.
 #define BASE_10_BIT_U_INT_BUFFER_SIZE MAX_NUM_BIT_U_INT_BITS / 3 + 1
 
+// The bits are packed in to 64 bit words, least significant word first.
+#define NUM_BIT_U_INT_WORDS ((MAX_NUM_BIT_U_INT_BITS + 63) / 64)
+
+// Only the low num_bits bits are part of the value. Any bits above that in
+// the words are ignored, so setting num_bits to 0 always gives zero.
 typedef struct {
   int num_bits;
-  uint8_t bits[MAX_NUM_BIT_U_INT_BITS];
+  uint64_t words[NUM_BIT_U_INT_WORDS];
 } BitUInt;
 
 // Sends the binary representation of the integer to stdout. The bits are
@@ -52,6 +57,20 @@ void BitUIntStore(const BitUInt* this, int buffer_size, char* buffer);
 // first.
 void BitUIntBase10Store(const BitUInt* this, int buffer_size, char* buffer);
 
+// Sets the value to a 64 bit unsigned integer, without leading zeros.
+void BitUIntSetUInt64(uint64_t value, BitUInt* this);
+
+// Provides the low 64 bits of the value.
+uint64_t BitUIntGetUInt64(const BitUInt* this);
+
+// Provides the bit at the given index, where index 0 is the lowest order
+// bit. Bits at or above num_bits are 0.
+int BitUIntGetBit(int index, const BitUInt* this);
+
+// Sets the bit at the given index to the value, which should be 0 or 1. The
+// index must be less than num_bits.
+void BitUIntSetBit(int value, int index, BitUInt* this);
+
 // Copies the value from the first argument into the second argument.
 void BitUIntClone(const BitUInt* that, BitUInt* this);
 
@@ -98,9 +117,19 @@ void BitUIntDiv(const BitUInt* numerator, const BitUInt* denominator,
 void BitUIntMod(const BitUInt* numerator, const BitUInt* denominator,
                 BitUInt* remainder);
 
-// Finds an integer that is close to the square root of the first argument
-// without being less than the actual square root. Intended for a rough
-// overestimate of the square root.
+// Finds the integer square root of the first argument, the largest integer
+// whose square does not exceed it.
+void BitUIntIsqrt(const BitUInt* this, BitUInt* root);
+
+// Updates root, the integer square root of some earlier value, to be the
+// integer square root of the first argument. The first argument must not be
+// smaller than the earlier value. This is cheap when it has only grown a
+// little.
+void BitUIntIsqrtUpdate(const BitUInt* this, BitUInt* root);
+
+// Finds the square root of the first argument rounded up, so the result is
+// never less than the actual square root. This is the integer square root,
+// plus one when the argument is not a perfect square.
 void BitUIntApproximateSquareRoot(const BitUInt* this, BitUInt* root);
 
 // Compares two large unsigned integers, returning 0 if they are equal, 1 if
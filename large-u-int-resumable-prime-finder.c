@@ -15,11 +15,17 @@
  */
 
 #include "large-u-int.h"
+#include "nearby-prime.h"
+#include "primes-writer.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
+
+// How often, in seconds, to report progress.
+#define REPORT_INTERVAL 60
 
 void PrintPrime(LargeUInt* prime, FILE* out) {
   LargeUIntPrint(prime, out);
@@ -28,34 +34,6 @@ void PrintPrime(LargeUInt* prime, FILE* out) {
   fprintf(out, "\n");
 }
 
-void FindNearbyPrime(LargeUInt* candidate) {
-  if (LargeUIntGetByte(0, candidate) % 2 == 0) {
-    LargeUIntIncrement(candidate);
-  }
-
-  LargeUInt quotient;
-  LargeUInt remainder;
-
-  LargeUInt max_divisor;
-  LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-  LargeUInt divisor;
-  LargeUIntInit(1, &divisor);
-  LargeUIntSetByte(3, 0, &divisor);
-  while (LargeUIntCompare(&divisor, &max_divisor) >= 0) {
-    LargeUIntDivide(candidate, &divisor, &quotient, &remainder);
-    if (LargeUIntNumBytes(&remainder) == 0) {
-      LargeUIntAddByte(2, candidate);
-      LargeUIntInit(1, &divisor);
-      LargeUIntSetByte(3, 0, &divisor);
-      LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-    } else {
-      LargeUIntAddByte(2, &divisor);
-    }
-  }
-
-  // We ran out of divisors so the value stored in candidate is prime.
-}
-
 void LoadNextPrime(FILE* primes, LargeUInt* prime) {
   LargeUIntRead(primes, prime);
 }
@@ -63,48 +41,103 @@ void LoadNextPrime(FILE* primes, LargeUInt* prime) {
 void FindHighestPrime(char* filename, LargeUInt* prime) {
   FILE* primes = fopen(filename, "r");
   if (primes == NULL) {
-    LargeUIntInit(0, prime);
+    LargeUIntSetUInt64(0, prime);
     return;
   }
 
   LargeUInt next_prime;
+  LargeUIntInit(0, &next_prime);
   LoadNextPrime(primes, &next_prime);
   while (LargeUIntNumBytes(&next_prime) != 0) {
     LargeUIntClone(&next_prime, prime);
     LoadNextPrime(primes, &next_prime);
   }
+  LargeUIntFree(&next_prime);
   fclose(primes);
   return;
 }
 
-void AppendPrime(char* filename, LargeUInt* prime) {
-  FILE* primes = fopen(filename, "a");
-  PrintPrime(prime, primes);
-  fclose(primes);
+// Adds the prime to the primes file in the format PrintPrime uses.
+void AppendPrime(PrimesWriter* primes, LargeUInt* prime) {
+  int hex_size = LargeUIntBufferSize(prime);
+  int base_10_size = LargeUIntBase10BufferSize(prime);
+  char* record = malloc(hex_size + base_10_size + 16);
+  if (record == NULL) {
+    fprintf(stderr, "Unable to allocate space for a prime record.\n");
+    exit(1);
+  }
+  LargeUIntStore(prime, hex_size, record);
+  strcat(record, " # int value: ");
+  int length = strlen(record);
+  LargeUIntBase10Store(prime, base_10_size, &record[length]);
+  strcat(record, "\n");
+  PrimesWriterAppend(record, strlen(record), primes);
+  free(record);
 }
 
-void GeneratePrimes(char* filename) {
+// A NearbyPrimeProgress which writes out the primes found so far while the
+// search for the next one goes on, since that can take a long time.
+void PollPrimesWriter(const LargeUInt* candidate, const LargeUInt* divisor,
+                      const LargeUInt* max_divisor, void* data) {
+  PrimesWriterPoll(data);
+}
+
+void GeneratePrimes(char* filename, int use_prp, int checkpoint_seconds) {
+  // Opening the writer first cuts off any line a crash left half written.
+  PrimesWriter primes;
+  PrimesWriterOpen(filename, checkpoint_seconds, &primes);
+
   // Start by finding the higest prime that we have so far.
   LargeUInt candidate;
+  LargeUIntInit(0, &candidate);
   printf("Looking for highest prime already found.\n");
   FindHighestPrime(filename, &candidate);
   printf("Starting from highest prime found so far: ");
   PrintPrime(&candidate, stdout);
   printf("\n");
 
-  // Add two to start trying new primes.
-  LargeUIntAddByte(2, &candidate);
-
+  // Progress is reported every REPORT_INTERVAL seconds rather than for each
+  // prime, since the primes file already holds every one of them.
+  time_t start_time = time(NULL);
+  time_t next_report = start_time + REPORT_INTERVAL;
+  uint_fast64_t primes_found = 0;
   while(1) {
-    FindNearbyPrime(&candidate);
-    AppendPrime(filename, &candidate);
-    printf("Found prime: ");
-    PrintPrime(&candidate, stdout);
-    LargeUIntAddByte(2, &candidate);
+    FindNextPrime(use_prp, PollPrimesWriter, &primes, &candidate);
+    AppendPrime(&primes, &candidate);
+    primes_found++;
+    if (time(NULL) >= next_report) {
+      printf("Found %llu primes, %.0f primes per second, the latest ",
+             (unsigned long long)primes_found,
+             (double)primes_found / (time(NULL) - start_time));
+      PrintPrime(&candidate, stdout);
+      next_report += REPORT_INTERVAL;
+    }
   }
 }
 
-int main() {
-  GeneratePrimes("primes");
+int main(int argc, char *argv[]) {
+  // The options are:
+  //   --prp              check each candidate with the Miller-Rabin test
+  //                      instead of trial division. Below
+  //                      3,317,044,064,679,887,385,961,981 the test is exact,
+  //                      so the primes file stays correct.
+  //   --checkpoint-seconds N
+  //                      sync the primes file to disk every N seconds
+  //                      instead of every minute.
+  int use_prp = 0;
+  int checkpoint_seconds = 0;
+  int i;
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--prp") == 0) {
+      use_prp = 1;
+    } else if (strcmp(argv[i], "--checkpoint-seconds") == 0 &&
+               i + 1 < argc) {
+      checkpoint_seconds = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      exit(1);
+    }
+  }
+  GeneratePrimes("primes", use_prp, checkpoint_seconds);
 }
 
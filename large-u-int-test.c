@@ -27,9 +27,9 @@ void Check(int condition, char* message) {
 }
 
 void CheckLargeUInt(char* expected, LargeUInt* this, char* message) {
-  char buffer[65];
-  LargeUIntStore(this, 65, buffer);
-  Check(0 == strncmp(expected, buffer, 65), message);
+  char buffer[200];
+  LargeUIntStore(this, 200, buffer);
+  Check(0 == strncmp(expected, buffer, 200), message);
 }
 
 void TestGetSetAndNumBytes() {
@@ -42,6 +42,8 @@ void TestGetSetAndNumBytes() {
   Check(255 == LargeUIntGetByte(0, &num), "Num byte 0 should be 255");
   Check(1 == LargeUIntGetByte(1, &num), "Num byte 0 should be 1");
   Check(76 == LargeUIntGetByte(2, &num), "Num byte 0 should be 76");
+
+  LargeUIntFree(&num);
 }
 
 void TestLoadAndStore() {
@@ -73,10 +75,13 @@ void TestLoadAndStore() {
   LargeUIntLoad(9, "0100_65", &a_int);
   LargeUIntBase10Store(&a_int, 30, a_str);
   Check(0 == strcmp("101", a_str), "Base 10 string should be \"101\"");
+
+  LargeUIntFree(&a_int);
 }
 
 void TestGrowAndTrim() {
   LargeUInt num;
+  LargeUIntInit(0, &num);
   char* numstr = "0300_000001";
   LargeUIntLoad(strlen(numstr), numstr, &num);
   Check(3 == LargeUIntNumBytes(&num), "Initially should have 3 bytes");
@@ -88,10 +93,14 @@ void TestGrowAndTrim() {
   LargeUIntSetByte(0, 2, &num);
   LargeUIntTrim(&num);
   Check(0 == LargeUIntNumBytes(&num), "Down to 0 bytes after trimming");
+
+  LargeUIntFree(&num);
 }
 
 void TestCompare() {
   LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
   LargeUIntLoad(11, "0300_431232", &a);
   LargeUIntLoad(9, "0200_4312", &b);
   Check(-1 == LargeUIntCompare(&a, &b),
@@ -125,17 +134,26 @@ void TestCompare() {
   Check(1 == LargeUIntLessThanOrEqual(&b, &b),
         "0x1C... is less than or equal to itself");
   Check(0 == LargeUIntLessThan(&b, &b), "0x1C... is not less than itself");
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
 }
 
 void TestClone() {
   LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
   LargeUIntLoad(11, "0300_AABBCC", &a);
   LargeUIntClone(&a, &b);
   Check(0 == LargeUIntCompare(&a, &b), "Cloned int should equal original");
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
 }
 
 void TestShift() {
   LargeUInt a;
+  LargeUIntInit(0, &a);
   LargeUIntLoad(11, "0300_AABBCC", &a);
   LargeUIntByteShiftInc(&a);
   CheckLargeUInt("0400_00AABBCC", &a, "Shift should add low order zero");
@@ -173,10 +191,14 @@ void TestShift() {
   LargeUIntMultiByteShiftDec(3, &a);
   CheckLargeUInt("0300_DDEEFF", &a,
                  "Multiple byte shift should remove three low order bytes");
+
+  LargeUIntFree(&a);
 }
 
 void TestAddAndIncrement() {
   LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
   LargeUIntLoad(11, "0300_FFFFFF", &a);
   LargeUIntLoad(7, "0100_02", &b);
   LargeUIntAdd(&b, &a);
@@ -195,10 +217,15 @@ void TestAddAndIncrement() {
   LargeUIntLoad(11, "0300_FFFFFF", &a);
   LargeUIntAddByte(3, &a);
   CheckLargeUInt("0400_02000001", &a, "Add byte 2 should carry to grow a");
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
 }
 
 void TestSubAndDecrement() {
   LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
   LargeUIntLoad(11, "0300_00000F", &a);
   LargeUIntLoad(7, "0100_03", &b);
   LargeUIntSub(&b, &a); // 983040 - 3 = 983037
@@ -218,10 +245,26 @@ void TestSubAndDecrement() {
   LargeUIntLoad(7, "0100_01", &a);
   LargeUIntDecrement(&a);
   CheckLargeUInt("0000_", &a, "After decrement should be 0");
+
+  // Equal values larger than the inline limbs leave zero behind, and the
+  // storage they keep still reads as zero once it grows again.
+  LargeUIntFree(&a);
+  LargeUIntInit(50, &a);
+  LargeUIntSetByte(1, 49, &a);
+  LargeUIntClone(&a, &b);
+  LargeUIntSub(&b, &a);
+  CheckLargeUInt("0000_", &a, "Equal values should subtract to 0");
+  LargeUIntAddByte(1, &a);
+  CheckLargeUInt("0100_01", &a, "Adding to the difference should give 1");
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
 }
 
 void TestMultiply() {
   LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
   LargeUIntLoad(7, "0100_05", &a);
   LargeUIntLoad(7, "0100_03", &b);
   LargeUIntMultiply(&b, &a);
@@ -234,10 +277,180 @@ void TestMultiply() {
   LargeUIntMultiply(&b, &a);
   CheckLargeUInt("0700_A0079200AB9C01", &a,
                  "Result should be 453,733,239,621,536");
+
+  LargeUIntLoad(21, "0000_", &b);
+  LargeUIntMultiply(&b, &a);
+  CheckLargeUInt("0000_", &a, "Multiplying by zero should give zero");
+
+  LargeUInt p;
+  LargeUIntInit(0, &p);
+  LargeUIntLoad(41, "1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF", &a);
+  LargeUIntSquare(&a, &p);
+  CheckLargeUInt(
+      "2000_01000000000000000000000000000000FEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+      &p, "Square of 2^128 - 1 should be 2^256 - 2^129 + 1");
+  LargeUIntProduct(&a, &a, &p);
+  CheckLargeUInt(
+      "2000_01000000000000000000000000000000FEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+      &p, "Product of a value with itself should match the square");
+
+  LargeUIntLoad(41, "1200_2301EFCDAB8967452301EFCDAB8967452301", &a);
+  LargeUIntLoad(29, "0C00_98BADCFE1032547698BADCFE", &b);
+  LargeUIntProduct(&a, &b, &p);
+  CheckLargeUInt(
+      "1E00_C81AD0A057961D44A1AD607380D1AA99CA3F91CC7A2442D777AD00FA2101",
+      &p, "Product of multiple limb values");
+  LargeUIntSquare(&a, &p);
+  CheckLargeUInt(
+      "2300_C94A5B2DB7A1555A3878020A853D7CC7A7A54FB97A925A49D678A8DCACF633"
+      "DC664B01",
+      &p, "Square of a multiple limb value");
+  LargeUIntMultiply(&a, &a);
+  CheckLargeUInt(
+      "2300_C94A5B2DB7A1555A3878020A853D7CC7A7A54FB97A925A49D678A8DCACF633"
+      "DC664B01",
+      &a, "Multiplying a value by itself in place should square it");
+  LargeUIntFree(&p);
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
 } 
 
+// Forms a value of num_bytes bytes from a simple pseudo random sequence.
+void FillLargeUInt(int num_bytes, unsigned int seed, LargeUInt* this) {
+  LargeUIntInit(num_bytes, this);
+  int i;
+  for (i = 0; i < num_bytes; i++) {
+    seed = seed * 1103515245 + 12345;
+    LargeUIntSetByte((seed >> 16) & 0xFF, i, this);
+  }
+  LargeUIntSetByte(0xFF, num_bytes - 1, this);
+}
+
+void TestBase10Load() {
+  LargeUInt a, b;
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
+
+  LargeUIntBase10Load(5, "32561", &a);
+  CheckLargeUInt("0200_317F", &a, "32561 should load as 0200_317F");
+
+  LargeUIntBase10Load(6, "  101\n", &a);
+  CheckLargeUInt("0100_65", &a, "Leading spaces should be skipped");
+
+  LargeUIntBase10Load(1, "0", &a);
+  Check(LargeUIntNumBytes(&a) == 0, "0 should load as zero");
+
+  // 10^19 is one past the largest 19 digit chunk.
+  LargeUIntBase10Load(20, "10000000000000000000", &a);
+  CheckLargeUInt("0800_0000E8890423C78A", &a,
+                 "10^19 should load as 0800_0000E8890423C78A");
+
+  // Large values are split by powers of ten in both directions, so check
+  // that a value with thousands of digits survives the round trip.
+  LargeUIntFree(&a);
+  FillLargeUInt(2000, 17, &a);
+  int buffer_size = LargeUIntBase10BufferSize(&a);
+  char* buffer = malloc(buffer_size);
+  LargeUIntBase10Store(&a, buffer_size, buffer);
+  Check(strlen(buffer) == 4817, "2000 byte value should have 4817 digits");
+  LargeUIntBase10Load(strlen(buffer), buffer, &b);
+  Check(LargeUIntEqual(&a, &b), "Decimal round trip should keep the value");
+
+  // Powers of ten have long runs of zero digits in every piece.
+  memset(buffer, '0', 1001);
+  buffer[0] = '1';
+  LargeUIntBase10Load(1001, buffer, &a);
+  LargeUIntBase10Store(&a, buffer_size, buffer);
+  Check(strlen(buffer) == 1001 && buffer[0] == '1' &&
+        strspn(buffer + 1, "0") == 1000, "10^1000 should be 1 then 0s");
+  free(buffer);
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
+}
+
+void TestFastMultiply() {
+  // Sizes which cover Karatsuba, Toom-Cook 3 with odd splits and the number
+  // theoretic transform, with balanced and unbalanced operands. Each product
+  // is checked against the schoolbook result.
+  int sizes[][2] = {{31, 31}, {100, 99}, {257, 257}, {600, 130}, {1001, 480}};
+  int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+  LargeUInt a, b, expected, actual;
+  LargeUIntInit(0, &expected);
+  LargeUIntInit(0, &actual);
+  int i;
+  for (i = 0; i < num_sizes; i++) {
+    FillLargeUInt(sizes[i][0], i, &a);
+    FillLargeUInt(sizes[i][1], i + 100, &b);
+
+    LargeUIntSetMultiplyThresholds(1000000, 1000000, 1000000);
+    LargeUIntProduct(&a, &b, &expected);
+    LargeUIntSetMultiplyThresholds(4, 9, 1000000);
+    LargeUIntProduct(&a, &b, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Toom-Cook 3 product should match the schoolbook result");
+    LargeUIntSetMultiplyThresholds(4, 1000000, 1000000);
+    LargeUIntProduct(&b, &a, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Karatsuba product should match the schoolbook result");
+    LargeUIntSetMultiplyThresholds(32, 128, 1);
+    LargeUIntProduct(&a, &b, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Transform product should match the schoolbook result");
+
+    LargeUIntSetMultiplyThresholds(1000000, 1000000, 1000000);
+    LargeUIntSquare(&a, &expected);
+    LargeUIntSetMultiplyThresholds(4, 9, 1000000);
+    LargeUIntSquare(&a, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Toom-Cook 3 square should match the schoolbook result");
+    LargeUIntSetMultiplyThresholds(5, 1000000, 1000000);
+    LargeUIntSquare(&a, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Karatsuba square should match the schoolbook result");
+    LargeUIntSetMultiplyThresholds(32, 128, 1);
+    LargeUIntSquare(&a, &actual);
+    Check(LargeUIntEqual(&expected, &actual),
+          "Transform square should match the schoolbook result");
+
+    LargeUIntFree(&a);
+    LargeUIntFree(&b);
+  }
+
+  // (2^4096 - 1)^2 = 2^8192 - 2^4097 + 1 has long carry and borrow chains.
+  LargeUIntInit(512, &a);
+  for (i = 0; i < 512; i++) {
+    LargeUIntSetByte(0xFF, i, &a);
+  }
+  LargeUIntFree(&expected);
+  LargeUIntInit(1024, &expected);
+  LargeUIntSetByte(0x01, 0, &expected);
+  LargeUIntSetByte(0xFE, 512, &expected);
+  for (i = 513; i < 1024; i++) {
+    LargeUIntSetByte(0xFF, i, &expected);
+  }
+  LargeUIntSetMultiplyThresholds(4, 9, 1000000);
+  LargeUIntSquare(&a, &actual);
+  Check(LargeUIntEqual(&expected, &actual),
+        "Square of 2^4096 - 1 should be 2^8192 - 2^4097 + 1");
+  LargeUIntSetMultiplyThresholds(32, 128, 1);
+  LargeUIntSquare(&a, &actual);
+  Check(LargeUIntEqual(&expected, &actual),
+        "Transform square of 2^4096 - 1 should be 2^8192 - 2^4097 + 1");
+  LargeUIntSetMultiplyThresholds(32, 128, 8192);
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&expected);
+  LargeUIntFree(&actual);
+}
+
 void TestDivide() {
   LargeUInt n, d, q, r;
+  LargeUIntInit(0, &n);
+  LargeUIntInit(0, &d);
+  LargeUIntInit(0, &q);
+  LargeUIntInit(0, &r);
   LargeUIntLoad(7, "0100_0F", &n);
   LargeUIntLoad(7, "0100_05", &d);
   LargeUIntDivide(&n, &d, &q, &r);
@@ -301,10 +514,36 @@ void TestDivide() {
   LargeUIntDivide(&n, &d, &q, &r);
   CheckLargeUInt("0300_230328", &q, "Quotient should be 2,622,243");
   CheckLargeUInt("0100_5E", &r, "Remainder should be 94");
+
+  // A multiple limb division where the first estimate of the quotient limb
+  // is one too large and the divisor has to be added back.
+  LargeUIntLoad(69,
+      "2000_000000000000008001000000000000000000000000000000FEFFFFFFFFFFFFFF",
+      &n);
+  LargeUIntLoad(53, "1800_0100000000000000FFFFFFFFFFFFFFFFFEFFFFFFFFFFFFFF",
+                &d);
+  LargeUIntDivide(&n, &d, &q, &r);
+  CheckLargeUInt("0800_FEFFFFFFFFFFFFFF", &q,
+                 "Quotient should be 2^64 - 2");
+  CheckLargeUInt("1800_0200000000000080FEFFFFFFFFFFFFFFFEFFFFFFFFFFFFFF", &r,
+                 "Remainder should survive the add back step");
+
+  // The quotient may be stored over the numerator.
+  LargeUIntDivide(&n, &d, &n, &r);
+  CheckLargeUInt("0800_FEFFFFFFFFFFFFFF", &n,
+                 "Quotient stored over the numerator should be 2^64 - 2");
+
+  LargeUIntFree(&n);
+  LargeUIntFree(&d);
+  LargeUIntFree(&q);
+  LargeUIntFree(&r);
 }
 
 void TestMod() {
   LargeUInt n, d, r;
+  LargeUIntInit(0, &n);
+  LargeUIntInit(0, &d);
+  LargeUIntInit(0, &r);
   LargeUIntLoad(7, "0100_0F", &n);
   LargeUIntLoad(7, "0100_05", &d);
   LargeUIntMod(&n, &d, &r);
@@ -344,10 +583,234 @@ void TestMod() {
   LargeUIntLoad(13, "0400_49531D1C", &d);
   LargeUIntMod(&n, &d, &r);
   CheckLargeUInt("0400_20BE900B", &r, "Mod remainder should be 194,035,232");
+
+  Check(LargeUIntModSmall(&n, 0x1C1D5349) == 194035232,
+        "Small mod remainder should be 194,035,232");
+  Check(LargeUIntModSmall(&n, 1) == 0, "Small mod by 1 should be 0");
+
+  // 0x2301EFCDAB8967452301EFCDAB8967452301 modulo word sized divisors.
+  LargeUIntLoad(41, "1200_0123456789ABCDEF0123456789ABCDEF0123", &n);
+  Check(LargeUIntModSmall(&n, 3) == 0, "Small mod by 3 should be 0");
+  Check(LargeUIntModSmall(&n, 1000003) == 615682,
+        "Small mod by 1,000,003 should be 615,682");
+  Check(LargeUIntModSmall(&n, 0x8000000000000001ULL) == 1167088121787672837ULL,
+        "Small mod by 2^63 + 1 should be 1,167,088,121,787,672,837");
+  Check(LargeUIntModSmall(&n, 0xFFFFFFFFFFFFFFC5ULL) == 3761688987611183549ULL,
+        "Small mod by 2^64 - 59 should be 3,761,688,987,611,183,549");
+
+  LargeUIntLoad(5, "0000_", &n);
+  Check(LargeUIntModSmall(&n, 7) == 0, "Small mod of 0 should be 0");
+
+  LargeUIntFree(&n);
+  LargeUIntFree(&d);
+  LargeUIntFree(&r);
+}
+
+void TestMontgomery() {
+  LargeUInt modulus, a, b, a_mont, b_mont, result, expected;
+  LargeUIntInit(0, &modulus);
+  LargeUIntInit(0, &a);
+  LargeUIntInit(0, &b);
+  LargeUIntInit(0, &a_mont);
+  LargeUIntInit(0, &b_mont);
+  LargeUIntInit(0, &result);
+  LargeUIntInit(0, &expected);
+  LargeUIntLoad(41, "1200_0123456789ABCDEF0123456789ABCDEF0123", &modulus);
+  LargeUIntLoad(37, "1000_FFEEDDCCBBAA99887766554433221100", &a);
+  LargeUIntLoad(41, "1200_89674523010000000000000000EFCDAB0023", &b);
+
+  LargeUIntMontCtx ctx;
+  LargeUIntMontInit(&modulus, &ctx);
+  LargeUIntToMont(&a, &ctx, &a_mont);
+  LargeUIntToMont(&b, &ctx, &b_mont);
+  LargeUIntFromMont(&a_mont, &ctx, &result);
+  Check(LargeUIntEqual(&a, &result),
+        "Value should be unchanged by a trip through Montgomery form");
+
+  LargeUIntMontMul(&a_mont, &b_mont, &ctx, &result);
+  LargeUIntFromMont(&result, &ctx, &result);
+  LargeUIntMultiply(&a, &b);
+  LargeUIntMod(&b, &modulus, &expected);
+  Check(LargeUIntEqual(&expected, &result),
+        "Montgomery product should match the product modulo the modulus");
+
+  LargeUIntMontSqr(&a_mont, &ctx, &a_mont);
+  LargeUIntFromMont(&a_mont, &ctx, &result);
+  LargeUIntMultiply(&a, &a);
+  LargeUIntMod(&a, &modulus, &expected);
+  Check(LargeUIntEqual(&expected, &result),
+        "Montgomery square should match the square modulo the modulus");
+
+  // Values at or above the modulus are reduced on the way in.
+  LargeUIntAdd(&modulus, &expected);
+  LargeUIntToMont(&expected, &ctx, &a_mont);
+  LargeUIntFromMont(&a_mont, &ctx, &result);
+  LargeUIntMod(&expected, &modulus, &expected);
+  Check(LargeUIntEqual(&expected, &result),
+        "Values above the modulus should be reduced by Montgomery form");
+  LargeUIntMontFree(&ctx);
+
+  // A single limb modulus.
+  LargeUIntSetUInt64(1000003, &modulus);
+  LargeUIntSetUInt64(999999, &a);
+  LargeUIntMontInit(&modulus, &ctx);
+  LargeUIntToMont(&a, &ctx, &a_mont);
+  LargeUIntMontSqr(&a_mont, &ctx, &a_mont);
+  LargeUIntFromMont(&a_mont, &ctx, &result);
+  CheckLargeUInt("0100_10", &result, "999,999^2 mod 1,000,003 should be 16");
+  LargeUIntMontFree(&ctx);
+
+  LargeUIntFree(&modulus);
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
+  LargeUIntFree(&a_mont);
+  LargeUIntFree(&b_mont);
+  LargeUIntFree(&result);
+  LargeUIntFree(&expected);
+}
+
+void TestPowMod() {
+  LargeUInt base, exponent, modulus, result;
+  LargeUIntInit(0, &base);
+  LargeUIntInit(0, &exponent);
+  LargeUIntInit(0, &modulus);
+  LargeUIntInit(0, &result);
+
+  LargeUIntSetUInt64(2, &base);
+  LargeUIntSetUInt64(10, &exponent);
+  LargeUIntSetUInt64(1000, &modulus);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("0100_18", &result, "2^10 mod 1000 should be 24");
+
+  LargeUIntSetUInt64(0, &exponent);
+  LargeUIntSetUInt64(7, &modulus);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("0100_01", &result, "2^0 mod 7 should be 1");
+
+  LargeUIntSetUInt64(1, &modulus);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("0000_", &result, "Anything mod 1 should be 0");
+
+  // Fermat's little theorem for the prime 2^127 - 1.
+  LargeUIntSetUInt64(3, &base);
+  LargeUIntLoad(37, "1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFF7F", &modulus);
+  LargeUIntLoad(37, "1000_FEFFFFFFFFFFFFFFFFFFFFFFFFFFFF7F", &exponent);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("0100_01", &result, "3^(p - 1) mod p should be 1");
+
+  LargeUIntLoad(37, "1000_FFEEDDCCBBAA00998877665544332211", &base);
+  LargeUIntLoad(41, "1200_0123456789ABCDEF0123456789ABCDEF0123", &modulus);
+  LargeUIntSetUInt64(65537, &exponent);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("1200_D4F438331BB4841A4917649C9B0D33785B12", &result,
+                 "Multiple limb power with a short exponent");
+  LargeUIntClone(&modulus, &exponent);
+  LargeUIntDecrement(&exponent);
+  LargeUIntPowMod(&base, &exponent, &modulus, &result);
+  CheckLargeUInt("1200_58D438A44410C4500961BA18578BE96DF018", &result,
+                 "Multiple limb power with a long exponent");
+
+  // An even modulus, with the result stored over the base.
+  LargeUIntIncrement(&modulus);
+  LargeUIntSetUInt64(65537, &exponent);
+  LargeUIntPowMod(&base, &exponent, &modulus, &base);
+  CheckLargeUInt("1200_3FB44E578BF15DA6780E2196CC6B2F1A981F", &base,
+                 "Power with an even modulus");
+
+  LargeUIntFree(&base);
+  LargeUIntFree(&exponent);
+  LargeUIntFree(&modulus);
+  LargeUIntFree(&result);
+}
+
+void TestIsProbablePrime() {
+  LargeUInt n;
+  LargeUIntInit(0, &n);
+  int expected[] = {0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 1};
+  int i;
+  for (i = 0; i < 14; i++) {
+    LargeUIntSetUInt64(i, &n);
+    Check(LargeUIntIsProbablePrime(&n, 1) == expected[i],
+          "Small values should be classified correctly");
+  }
+
+  LargeUIntSetUInt64(9409, &n);
+  Check(!LargeUIntIsProbablePrime(&n, 1), "97^2 should be composite");
+  LargeUIntSetUInt64(1000003, &n);
+  Check(LargeUIntIsProbablePrime(&n, 1), "1,000,003 should be prime");
+
+  // Strong pseudoprimes to the first 9, 12 and 13 prime bases.
+  LargeUIntLoad(21, "0800_FBF99A4F27911535", &n);
+  Check(!LargeUIntIsProbablePrime(&n, 1),
+        "3,825,123,056,546,413,051 should be composite");
+  LargeUIntLoad(25, "0A00_E5B785FCF91728E97A43", &n);
+  Check(!LargeUIntIsProbablePrime(&n, 1),
+        "318,665,857,834,031,151,167,461 should be composite");
+  LargeUIntLoad(27, "0B00_FDA51024B2C5AD5169BE02", &n);
+  Check(!LargeUIntIsProbablePrime(&n, 20),
+        "3,317,044,064,679,887,385,961,981 should be composite");
+
+  LargeUIntLoad(29, "0C00_FFFFFFFFFFFFFFFFFFFFFF01", &n);
+  Check(LargeUIntIsProbablePrime(&n, 20), "2^89 - 1 should be prime");
+  LargeUIntLoad(37, "1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFF7F", &n);
+  Check(LargeUIntIsProbablePrime(&n, 20), "2^127 - 1 should be prime");
+  LargeUIntLoad(53, "1800_01000000000000E0FFFFFFFFFFFFFF7FFFFFFFFFFFFFFF0F",
+                &n);
+  Check(!LargeUIntIsProbablePrime(&n, 20),
+        "(2^127 - 1) * (2^61 - 1) should be composite");
+
+  LargeUIntFree(&n);
+}
+
+void TestBailliePSW() {
+  LargeUInt n;
+  LargeUIntInit(0, &n);
+  LargeUIntSetUInt64(7, &n);
+  Check(LargeUIntJacobi(5, &n) == -1, "(5 / 7) should be -1");
+  LargeUIntSetUInt64(11, &n);
+  Check(LargeUIntJacobi(-7, &n) == 1, "(-7 / 11) should be 1");
+  LargeUIntSetUInt64(15, &n);
+  Check(LargeUIntJacobi(9, &n) == 0, "(9 / 15) should be 0");
+  LargeUIntSetUInt64(9907, &n);
+  Check(LargeUIntJacobi(1001, &n) == -1, "(1001 / 9907) should be -1");
+  LargeUIntLoad(37, "1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFF7F", &n);
+  Check(LargeUIntJacobi(-11, &n) == -1, "(-11 / 2^127 - 1) should be -1");
+  Check(LargeUIntJacobi(13, &n) == 1, "(13 / 2^127 - 1) should be 1");
+  Check(LargeUIntJacobi(2, &n) == 1, "(2 / 2^127 - 1) should be 1");
+
+  Check(LargeUIntIsBailliePSWPrime(&n), "2^127 - 1 should be prime");
+  LargeUIntLoad(53, "1800_01000000000000E0FFFFFFFFFFFFFF7FFFFFFFFFFFFFFF0F",
+                &n);
+  Check(!LargeUIntIsBailliePSWPrime(&n),
+        "(2^127 - 1) * (2^61 - 1) should be composite");
+
+  // 22,499 is a strong Lucas pseudoprime and 3,215,031,751 is a strong
+  // pseudoprime to bases 2, 3, 5 and 7. Each half of the test catches the
+  // other's pseudoprime.
+  LargeUIntSetUInt64(22499, &n);
+  Check(!LargeUIntIsBailliePSWPrime(&n), "22,499 should be composite");
+  LargeUIntSetUInt64(3215031751ULL, &n);
+  Check(!LargeUIntIsBailliePSWPrime(&n), "3,215,031,751 should be composite");
+
+  int expected[] = {0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 1};
+  int i;
+  for (i = 0; i < 14; i++) {
+    LargeUIntSetUInt64(i, &n);
+    Check(LargeUIntIsBailliePSWPrime(&n) == expected[i],
+          "Small values should be classified correctly");
+  }
+  LargeUIntSetUInt64(1018081, &n);
+  Check(!LargeUIntIsBailliePSWPrime(&n), "1009^2 should be composite");
+  LargeUIntSetUInt64(1000003, &n);
+  Check(LargeUIntIsBailliePSWPrime(&n), "1,000,003 should be prime");
+
+  LargeUIntFree(&n);
 }
 
 void TestApproximateSquareRoot() {
   LargeUInt n, root;
+  LargeUIntInit(0, &n);
+  LargeUIntInit(0, &root);
 
   LargeUIntLoad(7, "0100_04", &n);
   LargeUIntApproximateSquareRoot(&n, &root);
@@ -381,11 +844,111 @@ void TestApproximateSquareRoot() {
   LargeUIntApproximateSquareRoot(&n, &root);
   CheckLargeUInt("0400_692A9F02", &root,
                  "Root of 1,934,725,265,902,145 should be 43,985,513");
+
+  LargeUIntFree(&n);
+  LargeUIntFree(&root);
+}
+
+void TestIsqrt() {
+  LargeUInt n, root;
+  LargeUIntInit(0, &n);
+  LargeUIntInit(0, &root);
+
+  LargeUIntIsqrt(&n, &root);
+  Check(LargeUIntNumBytes(&root) == 0, "Integer root of 0 should be 0");
+
+  // 210 is just below 15 squared.
+  LargeUIntSetUInt64(210, &n);
+  LargeUIntIsqrt(&n, &root);
+  Check(LargeUIntGetUInt64(&root) == 14, "Integer root of 210 should be 14");
+  LargeUIntApproximateSquareRoot(&n, &root);
+  Check(LargeUIntGetUInt64(&root) == 15,
+        "Approximate root of 210 should be 15");
+
+  // Compare against the definition for every small value, stepping the
+  // incremental root along with it.
+  LargeUInt stepped_root;
+  LargeUIntInit(0, &stepped_root);
+  uint64_t i;
+  for (i = 1; i < 3000; i++) {
+    LargeUIntSetUInt64(i, &n);
+    LargeUIntIsqrt(&n, &root);
+    uint64_t r = LargeUIntGetUInt64(&root);
+    Check(r * r <= i && (r + 1) * (r + 1) > i,
+          "Integer root should be the floor of the square root");
+    LargeUIntIsqrtUpdate(&n, &stepped_root);
+    Check(LargeUIntEqual(&root, &stepped_root),
+          "Updated root should match the integer root");
+    LargeUIntApproximateSquareRoot(&n, &root);
+    Check(LargeUIntGetUInt64(&root) == (r * r == i ? r : r + 1),
+          "Approximate root should be the integer root rounded up");
+  }
+
+  // 2^256 - 1 has the integer root 2^128 - 1.
+  LargeUIntFree(&n);
+  LargeUIntInit(32, &n);
+  for (i = 0; i < 32; i++) {
+    LargeUIntSetByte(0xFF, i, &n);
+  }
+  LargeUIntIsqrt(&n, &root);
+  CheckLargeUInt("1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF", &root,
+                 "Integer root of 2^256 - 1 should be 2^128 - 1");
+
+  // Step a large root across the next perfect square, (2^128)^2.
+  LargeUIntIncrement(&n);
+  LargeUIntIsqrtUpdate(&n, &root);
+  CheckLargeUInt("1100_0000000000000000000000000000000001", &root,
+                 "Updated root of 2^256 should be 2^128");
+
+  LargeUIntFree(&n);
+  LargeUIntFree(&root);
+  LargeUIntFree(&stepped_root);
+}
+
+void TestLargeValues() {
+  LargeUInt a, b, q, r;
+  LargeUIntInit(100, &a);
+  LargeUIntInit(0, &b);
+  LargeUIntInit(0, &q);
+  LargeUIntInit(0, &r);
+  int i;
+  for (i = 0; i < 100; i++) {
+    LargeUIntSetByte(255, i, &a);
+  }
+  LargeUIntIncrement(&a);
+  Check(101 == LargeUIntNumBytes(&a), "2^800 should need 101 bytes");
+  Check(1 == LargeUIntGetByte(100, &a), "Top byte of 2^800 should be 1");
+  LargeUIntDecrement(&a);
+  Check(100 == LargeUIntNumBytes(&a), "2^800 - 1 should need 100 bytes");
+
+  LargeUIntClone(&a, &b);
+  LargeUIntAdd(&a, &b);
+  LargeUIntDivide(&b, &a, &q, &r);
+  CheckLargeUInt("0100_02", &q, "Doubled large value over itself is 2");
+  CheckLargeUInt("0000_", &r, "Doubled large value has no remainder");
+
+  LargeUIntSetUInt64(0x0123456789ABCDEF, &b);
+  CheckLargeUInt("0800_EFCDAB8967452301", &b, "Set from a 64 bit value");
+  LargeUIntMod(&a, &b, &r);
+  LargeUIntSub(&r, &a);
+  LargeUIntMod(&a, &b, &r);
+  CheckLargeUInt("0000_", &r, "Removing the remainder leaves a multiple");
+
+  LargeUIntFree(&a);
+  Check(0 == LargeUIntNumBytes(&a), "Freed int should be zero");
+  LargeUIntLoad(7, "0100_05", &a);
+  CheckLargeUInt("0100_05", &a, "Freed int can be reused");
+
+  LargeUIntFree(&a);
+  LargeUIntFree(&b);
+  LargeUIntFree(&q);
+  LargeUIntFree(&r);
 }
 
 int main(void) {
   TestGetSetAndNumBytes();
   TestLoadAndStore();
+  TestBase10Load();
   TestGrowAndTrim();
   TestCompare();
   TestClone();
@@ -393,8 +956,15 @@ int main(void) {
   TestAddAndIncrement();
   TestSubAndDecrement();
   TestMultiply();
+  TestFastMultiply();
   TestDivide();
   TestMod();
+  TestMontgomery();
+  TestPowMod();
+  TestIsProbablePrime();
+  TestBailliePSW();
   TestApproximateSquareRoot();
+  TestIsqrt();
+  TestLargeValues();
   printf("All tests passed\n");
 }
@@ -39,23 +39,890 @@ static int HexCharToNibble(char hex_char) {
   }
 }
 
+// Storage for limbs beyond the small limbs comes from per thread free lists,
+// one for each power of two number of limbs. Released storage goes back on
+// its list for reuse, so loops which repeatedly set up and release
+// temporaries stop calling malloc once the pool has warmed up.
+#define NUM_POOL_SIZE_CLASSES 32
+
+static __thread uint64_t* pool_free_lists[NUM_POOL_SIZE_CLASSES];
+
+// Provides storage for at least num_limbs limbs. The number of limbs which
+// are actually available is stored in capacity.
+static uint64_t* PoolAlloc(int num_limbs, int* capacity) {
+  int size_class = 0;
+  while ((1 << size_class) < num_limbs) {
+    size_class++;
+    if (size_class == NUM_POOL_SIZE_CLASSES - 1) {
+      ErrorOut("Unable to grow large integer.");
+    }
+  }
+
+  uint64_t* limbs = pool_free_lists[size_class];
+  if (limbs != NULL) {
+    // The first limb of a free block links to the next free block.
+    memcpy(&pool_free_lists[size_class], limbs, sizeof(uint64_t*));
+  } else {
+    limbs = malloc(sizeof(uint64_t) << size_class);
+    if (limbs == NULL) {
+      ErrorOut("Unable to allocate storage for a large integer.");
+    }
+  }
+  *capacity = 1 << size_class;
+  return limbs;
+}
+
+// Returns storage from PoolAlloc to the pool.
+static void PoolRelease(uint64_t* limbs, int capacity) {
+  int size_class = __builtin_ctz(capacity);
+  memcpy(limbs, &pool_free_lists[size_class], sizeof(uint64_t*));
+  pool_free_lists[size_class] = limbs;
+}
+
+// The number of limbs needed to hold the given number of bytes.
+static int LimbsForBytes(int num_bytes) {
+  return (num_bytes + 7) / 8;
+}
+
+static int NumLimbs(const LargeUInt* this) {
+  return LimbsForBytes(this->num_bytes_);
+}
+
+// The number of limbs in use, leaving out any which are zero at the top.
+static int TrimmedLimbs(const LargeUInt* this) {
+  int num_limbs = NumLimbs(this);
+  while (num_limbs > 0 && this->limbs_[num_limbs - 1] == 0) {
+    num_limbs--;
+  }
+  return num_limbs;
+}
+
+// Reads a byte from the limbs without any bounds checking.
+static int ByteAt(int index, const LargeUInt* this) {
+  return (this->limbs_[index / 8] >> (8 * (index % 8))) & 0xFF;
+}
+
+// Counts the bytes needed to hold the value in the limbs, ignoring any
+// leading zeroes.
+static int SignificantBytes(const uint64_t* limbs, int num_limbs) {
+  while (num_limbs > 0 && limbs[num_limbs - 1] == 0) {
+    num_limbs--;
+  }
+  if (num_limbs == 0) {
+    return 0;
+  }
+  int top_bits = 64 - __builtin_clzll(limbs[num_limbs - 1]);
+  return (num_limbs - 1) * 8 + (top_bits + 7) / 8;
+}
+
+static int BitLength(const LargeUInt* this) {
+  int num_limbs = TrimmedLimbs(this);
+  if (num_limbs == 0) {
+    return 0;
+  }
+  return 64 * num_limbs - __builtin_clzll(this->limbs_[num_limbs - 1]);
+}
+
+static int BitAt(int index, const LargeUInt* this) {
+  return (this->limbs_[index / 64] >> (index % 64)) & 1;
+}
+
+// Makes room for at least num_limbs limbs while keeping the current value.
+static void Reserve(int num_limbs, LargeUInt* this) {
+  if (num_limbs <= this->capacity_) {
+    return;
+  }
+  int capacity;
+  uint64_t* limbs = PoolAlloc(num_limbs, &capacity);
+  memcpy(limbs, this->limbs_, NumLimbs(this) * sizeof(uint64_t));
+  if (this->limbs_ != this->small_limbs_) {
+    PoolRelease(this->limbs_, this->capacity_);
+  }
+  this->limbs_ = limbs;
+  this->capacity_ = capacity;
+}
+
+// Ensures the limbs can hold the requested number of bytes, and clears any
+// limbs which are newly brought into use.
+static void Resize(int num_bytes, LargeUInt* this) {
+  Reserve(LimbsForBytes(num_bytes), this);
+  int i;
+  for (i = NumLimbs(this); i < LimbsForBytes(num_bytes); i++) {
+    this->limbs_[i] = 0;
+  }
+  this->num_bytes_ = num_bytes;
+}
+
+// Compares two runs of limbs which have the same length, using the same
+// return values as LargeUIntCompare.
+static int CompareLimbs(const uint64_t* a, const uint64_t* b, int num_limbs) {
+  int i;
+  for (i = num_limbs - 1; i >= 0; i--) {
+    if (a[i] != b[i]) {
+      return a[i] > b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// Subtracts b from a in place where a holds at least as many limbs as b. The
+// final borrow is returned.
+static uint64_t SubLimbs(const uint64_t* b, int b_limbs,
+                         uint64_t* a, int a_limbs) {
+  uint64_t borrow = 0;
+  unsigned __int128 diff;
+  int i;
+  for (i = 0; i < b_limbs; i++) {
+    diff = (unsigned __int128)a[i] - b[i] - borrow;
+    a[i] = (uint64_t)diff;
+    borrow = (uint64_t)(diff >> 64) & 1;
+  }
+  for (; i < a_limbs && borrow; i++) {
+    borrow = a[i] == 0;
+    a[i]--;
+  }
+  return borrow;
+}
+
+// Multiplies a by a single limb and adds the result into out, which must
+// have room for a_limbs limbs. The carry out of the top limb is returned.
+static uint64_t MultiplyAddLimb(const uint64_t* a, int a_limbs, uint64_t b,
+                                uint64_t* out) {
+  uint64_t carry = 0;
+  unsigned __int128 value;
+  int i;
+  for (i = 0; i < a_limbs; i++) {
+    value = (unsigned __int128)a[i] * b + out[i] + carry;
+    out[i] = (uint64_t)value;
+    carry = (uint64_t)(value >> 64);
+  }
+  return carry;
+}
+
+// Schoolbook multiplication, one row for each limb of b. The product has
+// a_limbs + b_limbs limbs and must not overlap either factor.
+static void MultiplyLimbs(const uint64_t* a, int a_limbs,
+                          const uint64_t* b, int b_limbs, uint64_t* product) {
+  memset(product, 0, (a_limbs + b_limbs) * sizeof(uint64_t));
+  int i;
+  for (i = 0; i < b_limbs; i++) {
+    product[i + a_limbs] = MultiplyAddLimb(a, a_limbs, b[i], product + i);
+  }
+}
+
+// Squares a into 2 * num_limbs limbs. Each cross product a[i] * a[j] for
+// i < j is only formed once and then doubled, which saves close to half of
+// the multiplications compared to MultiplyLimbs.
+static void SquareLimbs(const uint64_t* a, int num_limbs, uint64_t* square) {
+  int total_limbs = 2 * num_limbs;
+  memset(square, 0, total_limbs * sizeof(uint64_t));
+  int i;
+  for (i = 0; i < num_limbs - 1; i++) {
+    square[i + num_limbs] = MultiplyAddLimb(a + i + 1, num_limbs - i - 1,
+                                            a[i], square + 2 * i + 1);
+  }
+
+  // Double the cross products.
+  uint64_t top_bit = 0;
+  for (i = 0; i < total_limbs; i++) {
+    uint64_t next_top_bit = square[i] >> 63;
+    square[i] = (square[i] << 1) | top_bit;
+    top_bit = next_top_bit;
+  }
+
+  // Add in the squares of each limb along the diagonal.
+  uint64_t carry = 0;
+  unsigned __int128 value;
+  for (i = 0; i < num_limbs; i++) {
+    value = (unsigned __int128)a[i] * a[i];
+    unsigned __int128 low = (unsigned __int128)square[2 * i] +
+                            (uint64_t)value + carry;
+    square[2 * i] = (uint64_t)low;
+    unsigned __int128 high = (unsigned __int128)square[2 * i + 1] +
+                             (uint64_t)(value >> 64) + (uint64_t)(low >> 64);
+    square[2 * i + 1] = (uint64_t)high;
+    carry = (uint64_t)(high >> 64);
+  }
+}
+
+// Moves the value up by a number of bits, filling in zeroes at the low end.
+// The result has out_limbs limbs, any high bits shifted past that are lost.
+// Shifting in place is allowed.
+static void ShiftLimbsUp(const uint64_t* in, int in_limbs, int num_bits,
+                         uint64_t* out, int out_limbs) {
+  int limb_shift = num_bits / 64;
+  int bit_shift = num_bits % 64;
+  int i;
+  for (i = out_limbs - 1; i >= 0; i--) {
+    int source = i - limb_shift;
+    uint64_t value = 0;
+    if (source >= 0 && source < in_limbs) {
+      value = in[source] << bit_shift;
+    }
+    if (bit_shift > 0 && source - 1 >= 0 && source - 1 < in_limbs) {
+      value |= in[source - 1] >> (64 - bit_shift);
+    }
+    out[i] = value;
+  }
+}
+
+// Moves the value down by a number of bits, the low bits are dropped.
+// Shifting in place is allowed.
+static void ShiftLimbsDown(const uint64_t* in, int in_limbs, int num_bits,
+                           uint64_t* out, int out_limbs) {
+  int limb_shift = num_bits / 64;
+  int bit_shift = num_bits % 64;
+  int i;
+  for (i = 0; i < out_limbs; i++) {
+    int source = i + limb_shift;
+    uint64_t value = 0;
+    if (source < in_limbs) {
+      value = in[source] >> bit_shift;
+    }
+    if (bit_shift > 0 && source + 1 < in_limbs) {
+      value |= in[source + 1] << (64 - bit_shift);
+    }
+    out[i] = value;
+  }
+}
+
+// Finds -1 / odd modulo 2^64 for Montgomery reduction. Each step of Newton's
+// iteration doubles the number of correct low bits, and odd is already its
+// own inverse modulo 8.
+static uint64_t NegativeInverse(uint64_t odd) {
+  uint64_t inverse = odd;
+  int i;
+  for (i = 0; i < 5; i++) {
+    inverse *= 2 - odd * inverse;
+  }
+  return -inverse;
+}
+
+// Operand sizes, in limbs, at which multiplication moves on from the
+// schoolbook method to Karatsuba, from Karatsuba to Toom-Cook 3 and from
+// Toom-Cook 3 to number theoretic transforms. These can be tuned with
+// LargeUIntSetMultiplyThresholds.
+#define DEFAULT_KARATSUBA_THRESHOLD 32
+#define DEFAULT_TOOM_3_THRESHOLD 128
+#define DEFAULT_NTT_THRESHOLD 8192
+
+static int karatsuba_threshold = DEFAULT_KARATSUBA_THRESHOLD;
+static int toom_3_threshold = DEFAULT_TOOM_3_THRESHOLD;
+static int ntt_threshold = DEFAULT_NTT_THRESHOLD;
+
+// Adds b into a where a holds at least as many limbs as b. The final carry
+// is returned.
+static uint64_t AddLimbs(const uint64_t* b, int b_limbs,
+                         uint64_t* a, int a_limbs) {
+  uint64_t carry = 0;
+  unsigned __int128 sum;
+  int i;
+  for (i = 0; i < b_limbs; i++) {
+    sum = (unsigned __int128)a[i] + b[i] + carry;
+    a[i] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
+  }
+  for (; i < a_limbs && carry; i++) {
+    a[i]++;
+    carry = a[i] == 0;
+  }
+  return carry;
+}
+
+// Sets out to |a - b| where a and b are zero extended to out_limbs limbs.
+// Returns 1 when b is larger than a, otherwise 0.
+static int AbsDiffLimbs(const uint64_t* a, int a_limbs,
+                        const uint64_t* b, int b_limbs,
+                        uint64_t* out, int out_limbs) {
+  int i;
+  int comparison = 0;
+  for (i = out_limbs - 1; i >= 0 && comparison == 0; i--) {
+    uint64_t a_limb = i < a_limbs ? a[i] : 0;
+    uint64_t b_limb = i < b_limbs ? b[i] : 0;
+    if (a_limb != b_limb) {
+      comparison = a_limb > b_limb ? -1 : 1;
+    }
+  }
+  if (comparison == 1) {
+    const uint64_t* swap_limbs = a;
+    int swap_num_limbs = a_limbs;
+    a = b;
+    a_limbs = b_limbs;
+    b = swap_limbs;
+    b_limbs = swap_num_limbs;
+  }
+  memset(out, 0, out_limbs * sizeof(uint64_t));
+  memcpy(out, a, a_limbs * sizeof(uint64_t));
+  SubLimbs(b, b_limbs, out, out_limbs);
+  return comparison == 1;
+}
+
+// Replaces a with its two's complement negation over num_limbs limbs.
+static void NegateLimbs(uint64_t* a, int num_limbs) {
+  uint64_t carry = 1;
+  int i;
+  for (i = 0; i < num_limbs; i++) {
+    a[i] = ~a[i] + carry;
+    carry = carry && a[i] == 0;
+  }
+}
+
+// Halves a two's complement value which is known to be even.
+static void HalveSignedLimbs(uint64_t* a, int num_limbs) {
+  uint64_t sign = a[num_limbs - 1] >> 63;
+  ShiftLimbsDown(a, num_limbs, 1, a, num_limbs);
+  a[num_limbs - 1] |= sign << 63;
+}
+
+// Divides a value which is known to be a multiple of 3 by 3. This works on
+// two's complement values too, since it multiplies by the inverse of 3
+// modulo 2^(64 * num_limbs).
+static void DivideExactBy3(uint64_t* a, int num_limbs) {
+  const uint64_t inverse_of_3 = 0xAAAAAAAAAAAAAAABULL;
+  uint64_t borrow = 0;
+  int i;
+  for (i = 0; i < num_limbs; i++) {
+    uint64_t limb = a[i] - borrow;
+    borrow = limb > a[i];
+    a[i] = limb * inverse_of_3;
+    borrow += (uint64_t)(((unsigned __int128)a[i] * 3) >> 64);
+  }
+}
+
+static void MultiplyBalanced(const uint64_t* a, const uint64_t* b,
+                             int num_limbs, uint64_t* product);
+
+// Karatsuba multiplication of two num_limbs values, splitting each in to a
+// low half of m limbs and a high half. Three half sized products are needed
+// instead of four:
+// a * b = z0 + (z0 + z2 + (a0 - a1)(b1 - b0)) * B^m + z2 * B^2m
+// where z0 = a0 * b0 and z2 = a1 * b1. When a and b are the same, squares
+// are used throughout.
+static void MultiplyKaratsuba(const uint64_t* a, const uint64_t* b,
+                              int num_limbs, uint64_t* product) {
+  int m = (num_limbs + 1) / 2;
+  int high_limbs = num_limbs - m;
+  int squaring = a == b;
+
+  int capacity;
+  uint64_t* scratch = PoolAlloc(6 * m + 1, &capacity);
+  uint64_t* a_diff = scratch;
+  uint64_t* b_diff = scratch + m;
+  uint64_t* middle = scratch + 2 * m;
+  uint64_t* cross = scratch + 4 * m + 1;
+
+  MultiplyBalanced(a, b, m, product);
+  MultiplyBalanced(a + m, b + m, high_limbs, product + 2 * m);
+
+  int negative = AbsDiffLimbs(a, m, a + m, high_limbs, a_diff, m);
+  if (squaring) {
+    MultiplyBalanced(a_diff, a_diff, m, cross);
+    negative = 1;
+  } else {
+    negative ^= AbsDiffLimbs(b + m, high_limbs, b, m, b_diff, m);
+    MultiplyBalanced(a_diff, b_diff, m, cross);
+  }
+
+  // Sum the outer products and adjust by the cross term to get the middle.
+  memcpy(middle, product, 2 * m * sizeof(uint64_t));
+  middle[2 * m] = 0;
+  AddLimbs(product + 2 * m, 2 * high_limbs, middle, 2 * m + 1);
+  if (negative) {
+    SubLimbs(cross, 2 * m, middle, 2 * m + 1);
+  } else {
+    AddLimbs(cross, 2 * m, middle, 2 * m + 1);
+  }
+
+  int room = 2 * num_limbs - m;
+  AddLimbs(middle, 2 * m + 1 < room ? 2 * m + 1 : room, product + m, room);
+  PoolRelease(scratch, capacity);
+}
+
+// Evaluates a three part split of a at the points 1, -1 and 2. The low and
+// middle parts have k limbs and the high part has high_limbs limbs. Each
+// result has k + 1 limbs. Returns 1 if the value at -1 is negative, in which
+// case its magnitude is stored.
+static int EvaluateToom3(const uint64_t* a, int k, int high_limbs,
+                         uint64_t* at_1, uint64_t* at_minus_1,
+                         uint64_t* at_2) {
+  const uint64_t* a0 = a;
+  const uint64_t* a1 = a + k;
+  const uint64_t* a2 = a + 2 * k;
+
+  // a0 + a2 is shared between the values at 1 and -1.
+  memcpy(at_1, a0, k * sizeof(uint64_t));
+  at_1[k] = 0;
+  AddLimbs(a2, high_limbs, at_1, k + 1);
+  int negative = AbsDiffLimbs(at_1, k + 1, a1, k, at_minus_1, k + 1);
+  AddLimbs(a1, k, at_1, k + 1);
+
+  // ((2 * a2) + a1) * 2 + a0
+  memset(at_2, 0, (k + 1) * sizeof(uint64_t));
+  ShiftLimbsUp(a2, high_limbs, 1, at_2, k + 1);
+  AddLimbs(a1, k, at_2, k + 1);
+  ShiftLimbsUp(at_2, k + 1, 1, at_2, k + 1);
+  AddLimbs(a0, k, at_2, k + 1);
+  return negative;
+}
+
+// Toom-Cook 3 multiplication of two num_limbs values. Each is split in to
+// three parts and treated as a polynomial which is evaluated at 0, 1, -1, 2
+// and infinity. The five products of those values are interpolated back in
+// to the five coefficients c0 to c4 of the product. The intermediate values
+// may go negative so they are kept in two's complement.
+static void MultiplyToom3(const uint64_t* a, const uint64_t* b,
+                          int num_limbs, uint64_t* product) {
+  int k = (num_limbs + 2) / 3;
+  int high_limbs = num_limbs - 2 * k;
+  int width = 2 * k + 3;
+  int squaring = a == b;
+
+  int capacity;
+  uint64_t* scratch = PoolAlloc(6 * (k + 1) + 3 * width, &capacity);
+  uint64_t* a_at_1 = scratch;
+  uint64_t* a_at_minus_1 = a_at_1 + k + 1;
+  uint64_t* a_at_2 = a_at_minus_1 + k + 1;
+  uint64_t* b_at_1 = a_at_2 + k + 1;
+  uint64_t* b_at_minus_1 = b_at_1 + k + 1;
+  uint64_t* b_at_2 = b_at_minus_1 + k + 1;
+  uint64_t* r1 = b_at_2 + k + 1;
+  uint64_t* r_minus_1 = r1 + width;
+  uint64_t* r2 = r_minus_1 + width;
+
+  int negative = EvaluateToom3(a, k, high_limbs,
+                               a_at_1, a_at_minus_1, a_at_2);
+  if (squaring) {
+    b_at_1 = a_at_1;
+    b_at_minus_1 = a_at_minus_1;
+    b_at_2 = a_at_2;
+    negative = 0;
+  } else {
+    negative ^= EvaluateToom3(b, k, high_limbs,
+                              b_at_1, b_at_minus_1, b_at_2);
+  }
+
+  // The products at 0 and infinity go straight to their final places.
+  const uint64_t* r0 = product;
+  const uint64_t* r_infinity = product + 4 * k;
+  int infinity_limbs = 2 * high_limbs;
+  MultiplyBalanced(a, b, k, product);
+  memset(product + 2 * k, 0, 2 * k * sizeof(uint64_t));
+  MultiplyBalanced(a + 2 * k, b + 2 * k, high_limbs, product + 4 * k);
+
+  r1[width - 1] = 0;
+  r_minus_1[width - 1] = 0;
+  r2[width - 1] = 0;
+  MultiplyBalanced(a_at_1, b_at_1, k + 1, r1);
+  MultiplyBalanced(a_at_minus_1, b_at_minus_1, k + 1, r_minus_1);
+  MultiplyBalanced(a_at_2, b_at_2, k + 1, r2);
+  if (negative) {
+    NegateLimbs(r_minus_1, width);
+  }
+
+  // Bodrato's interpolation sequence, which leaves c1 in r_minus_1, c2 in
+  // r1 and c3 in r2.
+  SubLimbs(r_minus_1, width, r2, width);
+  DivideExactBy3(r2, width);
+  NegateLimbs(r_minus_1, width);
+  AddLimbs(r1, width, r_minus_1, width);
+  HalveSignedLimbs(r_minus_1, width);
+  SubLimbs(r0, 2 * k, r1, width);
+  SubLimbs(r1, width, r2, width);
+  HalveSignedLimbs(r2, width);
+  SubLimbs(r_minus_1, width, r1, width);
+  SubLimbs(r_infinity, infinity_limbs, r1, width);
+  SubLimbs(r_infinity, infinity_limbs, r2, width);
+  SubLimbs(r_infinity, infinity_limbs, r2, width);
+  SubLimbs(r2, width, r_minus_1, width);
+
+  // The remaining coefficients are all positive now, add them in to place.
+  int total_limbs = 2 * num_limbs;
+  int room = total_limbs - k;
+  AddLimbs(r_minus_1, width < room ? width : room, product + k, room);
+  room = total_limbs - 2 * k;
+  AddLimbs(r1, width < room ? width : room, product + 2 * k, room);
+  room = total_limbs - 3 * k;
+  AddLimbs(r2, width < room ? width : room, product + 3 * k, room);
+  PoolRelease(scratch, capacity);
+}
+
+// Number theoretic transform multiplication. The limbs are convolved modulo
+// three primes of the form c * 2^k + 1 which all have roots of unity for
+// power of two lengths up to 2^50. Each coefficient of the convolution is
+// less than length * 2^128, which is below the product of the primes, so
+// the exact coefficients are recovered with the Chinese remainder theorem.
+// There is no rounding to go wrong as there would be with a floating point
+// FFT.
+#define NUM_NTT_PRIMES 3
+#define MAX_NTT_LOG_LENGTH 50
+
+static const uint64_t kNttPrimes[NUM_NTT_PRIMES] = {
+  0x3FDC000000000001ULL, 0x3F18000000000001ULL, 0x3EA0000000000001ULL
+};
+
+// A generator of the multiplicative group for each prime.
+static const uint64_t kNttGenerators[NUM_NTT_PRIMES] = {3, 10, 7};
+
+// The constants for Montgomery multiplication modulo one of the primes with
+// R = 2^64, and the twiddle factors for transforms of up to length limbs.
+// Entries m to 2m - 1 of the twiddle tables hold the powers of a primitive
+// 2m-th root of unity used by one stage of the transform, so a table built
+// for one length serves every shorter length too.
+typedef struct {
+  uint64_t prime;
+  uint64_t negative_inverse;  // -1 / prime modulo R
+  uint64_t r_squared;  // R^2 modulo prime
+  int length;
+  uint64_t* twiddles;
+  uint64_t* inverse_twiddles;
+} NttPrime;
+
+static __thread NttPrime ntt_primes[NUM_NTT_PRIMES];
+
+// Returns a * b / R modulo the prime, given a * b < prime * R.
+static uint64_t MontgomeryReduce(unsigned __int128 value,
+                                 const NttPrime* prime) {
+  uint64_t m = (uint64_t)value * prime->negative_inverse;
+  uint64_t result = (uint64_t)((value +
+                                (unsigned __int128)m * prime->prime) >> 64);
+  return result >= prime->prime ? result - prime->prime : result;
+}
+
+static uint64_t NttMultiply(uint64_t a, uint64_t b, const NttPrime* prime) {
+  return MontgomeryReduce((unsigned __int128)a * b, prime);
+}
+
+static uint64_t NttAdd(uint64_t a, uint64_t b, const NttPrime* prime) {
+  uint64_t sum = a + b;
+  return sum >= prime->prime ? sum - prime->prime : sum;
+}
+
+static uint64_t NttSub(uint64_t a, uint64_t b, const NttPrime* prime) {
+  return a >= b ? a - b : a + prime->prime - b;
+}
+
+// Raises a value in Montgomery form to a power, leaving it in Montgomery
+// form.
+static uint64_t NttPower(uint64_t base, uint64_t exponent,
+                         const NttPrime* prime) {
+  uint64_t result = NttMultiply(1, prime->r_squared, prime);
+  while (exponent > 0) {
+    if (exponent & 1) {
+      result = NttMultiply(result, base, prime);
+    }
+    base = NttMultiply(base, base, prime);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// Makes sure the twiddle tables for the prime cover transforms of the given
+// length. The tables are kept for later multiplications in this thread.
+static void PrepareNttPrime(int index, int length) {
+  NttPrime* prime = &ntt_primes[index];
+  if (prime->length >= length) {
+    return;
+  }
+  if (prime->length == 0) {
+    uint64_t p = kNttPrimes[index];
+    prime->prime = p;
+    prime->negative_inverse = NegativeInverse(p);
+    uint64_t r = (0 - p) % p;
+    prime->r_squared = (uint64_t)((unsigned __int128)r * r % p);
+  }
+
+  free(prime->twiddles);
+  free(prime->inverse_twiddles);
+  prime->twiddles = malloc(length * sizeof(uint64_t));
+  prime->inverse_twiddles = malloc(length * sizeof(uint64_t));
+  if (prime->twiddles == NULL || prime->inverse_twiddles == NULL) {
+    ErrorOut("Unable to allocate space for transform twiddle factors.");
+  }
+  prime->length = length;
+
+  uint64_t generator = NttMultiply(kNttGenerators[index], prime->r_squared,
+                                   prime);
+  int m;
+  for (m = 1; m < length; m *= 2) {
+    uint64_t root = NttPower(generator, (prime->prime - 1) / (2 * m), prime);
+    uint64_t inverse_root = NttPower(root, 2 * m - 1, prime);
+    uint64_t twiddle = NttMultiply(1, prime->r_squared, prime);
+    uint64_t inverse_twiddle = twiddle;
+    int j;
+    for (j = 0; j < m; j++) {
+      prime->twiddles[m + j] = twiddle;
+      prime->inverse_twiddles[m + j] = inverse_twiddle;
+      twiddle = NttMultiply(twiddle, root, prime);
+      inverse_twiddle = NttMultiply(inverse_twiddle, inverse_root, prime);
+    }
+  }
+}
+
+// Decimation in frequency transform, the output is in bit reversed order.
+static void NttForward(uint64_t* values, int length, const NttPrime* prime) {
+  int m;
+  for (m = length / 2; m >= 1; m /= 2) {
+    const uint64_t* twiddles = prime->twiddles + m;
+    int start;
+    for (start = 0; start < length; start += 2 * m) {
+      uint64_t* low = values + start;
+      uint64_t* high = low + m;
+      int j;
+      for (j = 0; j < m; j++) {
+        uint64_t u = low[j];
+        uint64_t v = high[j];
+        low[j] = NttAdd(u, v, prime);
+        high[j] = NttMultiply(NttSub(u, v, prime), twiddles[j], prime);
+      }
+    }
+  }
+}
+
+// Decimation in time inverse transform taking bit reversed input. The
+// output is length times the original values.
+static void NttInverse(uint64_t* values, int length, const NttPrime* prime) {
+  int m;
+  for (m = 1; m < length; m *= 2) {
+    const uint64_t* twiddles = prime->inverse_twiddles + m;
+    int start;
+    for (start = 0; start < length; start += 2 * m) {
+      uint64_t* low = values + start;
+      uint64_t* high = low + m;
+      int j;
+      for (j = 0; j < m; j++) {
+        uint64_t u = low[j];
+        uint64_t v = NttMultiply(high[j], twiddles[j], prime);
+        low[j] = NttAdd(u, v, prime);
+        high[j] = NttSub(u, v, prime);
+      }
+    }
+  }
+}
+
+// Loads the limbs reduced modulo the prime, padded with zeroes to length.
+static void NttLoad(const uint64_t* a, int a_limbs, int length,
+                    const NttPrime* prime, uint64_t* values) {
+  int i;
+  for (i = 0; i < a_limbs; i++) {
+    values[i] = a[i] % prime->prime;
+  }
+  memset(values + a_limbs, 0, (length - a_limbs) * sizeof(uint64_t));
+}
+
+// Computes the cyclic convolution of a and b modulo one prime into values.
+// When a and b are the same the single transform is squared in place.
+static void NttConvolve(const uint64_t* a, int a_limbs,
+                        const uint64_t* b, int b_limbs, int length,
+                        const NttPrime* prime, uint64_t* values,
+                        uint64_t* scratch) {
+  int i;
+  NttLoad(a, a_limbs, length, prime, values);
+  NttForward(values, length, prime);
+  if (a == b) {
+    for (i = 0; i < length; i++) {
+      values[i] = NttMultiply(values[i], values[i], prime);
+    }
+  } else {
+    NttLoad(b, b_limbs, length, prime, scratch);
+    NttForward(scratch, length, prime);
+    for (i = 0; i < length; i++) {
+      values[i] = NttMultiply(values[i], scratch[i], prime);
+    }
+  }
+  NttInverse(values, length, prime);
+
+  // The pointwise products picked up a factor of 1 / R and the inverse
+  // transform a factor of length. Both are removed with one multiply by
+  // R^2 / length, which comes out of Montgomery form as R / length.
+  uint64_t inverse_length = prime->prime - (prime->prime - 1) / length;
+  uint64_t scale = NttMultiply(NttMultiply(inverse_length, prime->r_squared,
+                                           prime),
+                               prime->r_squared, prime);
+  for (i = 0; i < length; i++) {
+    values[i] = NttMultiply(values[i], scale, prime);
+  }
+}
+
+static uint64_t MultiplyMod(uint64_t a, uint64_t b, uint64_t modulus) {
+  return (uint64_t)((unsigned __int128)a * b % modulus);
+}
+
+static uint64_t PowerMod(uint64_t base, uint64_t exponent, uint64_t modulus) {
+  uint64_t result = 1;
+  while (exponent > 0) {
+    if (exponent & 1) {
+      result = MultiplyMod(result, base, modulus);
+    }
+    base = MultiplyMod(base, base, modulus);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// Multiplies a by b using number theoretic transforms. Passing the same
+// limbs for a and b squares the value with one transform per prime.
+static void MultiplyNtt(const uint64_t* a, int a_limbs,
+                        const uint64_t* b, int b_limbs, uint64_t* product) {
+  int total_limbs = a_limbs + b_limbs;
+  int length = 1;
+  int log_length = 0;
+  while (length < total_limbs - 1) {
+    length *= 2;
+    log_length++;
+  }
+  if (log_length > MAX_NTT_LOG_LENGTH) {
+    ErrorOut("Factors are too large for the number theoretic transform.");
+  }
+
+  int capacity;
+  int scratch_capacity = 0;
+  uint64_t* residues = PoolAlloc(NUM_NTT_PRIMES * length, &capacity);
+  uint64_t* scratch = NULL;
+  if (a != b) {
+    scratch = PoolAlloc(length, &scratch_capacity);
+  }
+  int i;
+  for (i = 0; i < NUM_NTT_PRIMES; i++) {
+    PrepareNttPrime(i, length);
+    NttConvolve(a, a_limbs, b, b_limbs, length, &ntt_primes[i],
+                residues + i * length, scratch);
+  }
+  if (scratch != NULL) {
+    PoolRelease(scratch, scratch_capacity);
+  }
+
+  // Garner's algorithm rebuilds each coefficient from its residues as
+  // x = r0 + p0 * (v1 + p1 * v2), and the coefficients are then added
+  // together with carries to form the product.
+  uint64_t p0 = kNttPrimes[0];
+  uint64_t p1 = kNttPrimes[1];
+  uint64_t p2 = kNttPrimes[2];
+  uint64_t p0_inverse_mod_p1 = PowerMod(p0 % p1, p1 - 2, p1);
+  uint64_t p0_p1_inverse_mod_p2 = PowerMod(MultiplyMod(p0 % p2, p1 % p2, p2),
+                                           p2 - 2, p2);
+  unsigned __int128 p0_p1 = (unsigned __int128)p0 * p1;
+  uint64_t carry[3] = {0, 0, 0};
+  for (i = 0; i < total_limbs; i++) {
+    uint64_t coefficient[3] = {0, 0, 0};
+    if (i < length) {
+      uint64_t r0 = residues[i];
+      uint64_t r1 = residues[length + i];
+      uint64_t r2 = residues[2 * length + i];
+      uint64_t v1 = MultiplyMod((r1 + p1 - r0 % p1) % p1, p0_inverse_mod_p1,
+                                p1);
+      uint64_t partial = (uint64_t)(((unsigned __int128)v1 * p0 + r0) % p2);
+      uint64_t v2 = MultiplyMod((r2 + p2 - partial) % p2, p0_p1_inverse_mod_p2,
+                                p2);
+      // coefficient = r0 + v1 * p0 + v2 * p0 * p1
+      unsigned __int128 low = (unsigned __int128)v1 * p0 + r0;
+      uint64_t low_limbs[2] = {(uint64_t)low, (uint64_t)(low >> 64)};
+      unsigned __int128 low_part = (unsigned __int128)v2 * (uint64_t)p0_p1;
+      unsigned __int128 high_part =
+          (unsigned __int128)v2 * (uint64_t)(p0_p1 >> 64);
+      coefficient[0] = (uint64_t)low_part;
+      unsigned __int128 middle = (low_part >> 64) + (uint64_t)high_part;
+      coefficient[1] = (uint64_t)middle;
+      coefficient[2] = (uint64_t)(high_part >> 64) +
+                       (uint64_t)(middle >> 64);
+      AddLimbs(low_limbs, 2, coefficient, 3);
+    }
+    AddLimbs(carry, 3, coefficient, 3);
+    product[i] = coefficient[0];
+    carry[0] = coefficient[1];
+    carry[1] = coefficient[2];
+    carry[2] = 0;
+  }
+  PoolRelease(residues, capacity);
+}
+
+// Multiplies two values which have the same number of limbs, picking the
+// method by size. Passing the same limbs for a and b squares the value.
+static void MultiplyBalanced(const uint64_t* a, const uint64_t* b,
+                             int num_limbs, uint64_t* product) {
+  if (num_limbs >= ntt_threshold) {
+    MultiplyNtt(a, num_limbs, b, num_limbs, product);
+  } else if (num_limbs < karatsuba_threshold) {
+    if (a == b) {
+      SquareLimbs(a, num_limbs, product);
+    } else {
+      MultiplyLimbs(a, num_limbs, b, num_limbs, product);
+    }
+  } else if (num_limbs < toom_3_threshold) {
+    MultiplyKaratsuba(a, b, num_limbs, product);
+  } else {
+    MultiplyToom3(a, b, num_limbs, product);
+  }
+}
+
+// Multiplies values of any size where a has at least as many limbs as b.
+// When a is much longer, it is multiplied by b in pieces which are the size
+// of b so the balanced methods can still be used.
+static void MultiplyUnbalanced(const uint64_t* a, int a_limbs,
+                               const uint64_t* b, int b_limbs,
+                               uint64_t* product) {
+  if (b_limbs < karatsuba_threshold) {
+    MultiplyLimbs(a, a_limbs, b, b_limbs, product);
+    return;
+  }
+  if (a_limbs == b_limbs) {
+    MultiplyBalanced(a, b, b_limbs, product);
+    return;
+  }
+  if (b_limbs >= ntt_threshold) {
+    MultiplyNtt(a, a_limbs, b, b_limbs, product);
+    return;
+  }
+
+  int total_limbs = a_limbs + b_limbs;
+  memset(product, 0, total_limbs * sizeof(uint64_t));
+  int capacity;
+  uint64_t* piece = PoolAlloc(2 * b_limbs, &capacity);
+  int offset;
+  for (offset = 0; offset < a_limbs; offset += b_limbs) {
+    int piece_limbs = a_limbs - offset < b_limbs ? a_limbs - offset : b_limbs;
+    if (piece_limbs == b_limbs) {
+      MultiplyBalanced(a + offset, b, b_limbs, piece);
+    } else {
+      MultiplyUnbalanced(b, b_limbs, a + offset, piece_limbs, piece);
+    }
+    AddLimbs(piece, piece_limbs + b_limbs, product + offset,
+             total_limbs - offset);
+  }
+  PoolRelease(piece, capacity);
+}
+
 void LargeUIntPrint(const LargeUInt* this, FILE* out) {
+  if (this->num_bytes_ > MAX_NUM_LARGE_U_INT_BYTES) {
+    ErrorOut("Large integer is too big for the text format.");
+  }
   int i;
   fprintf(out, "%c%c%c%c_",
           kHexBytes[this->num_bytes_ >> 4 & 0x0F],
-          kHexBytes[this->num_bytes_ & 0x0F], 
+          kHexBytes[this->num_bytes_ & 0x0F],
           kHexBytes[this->num_bytes_ >> 12 & 0x0F],
           kHexBytes[this->num_bytes_ >> 8 & 0x0F]);
   for (i = 0; i < this->num_bytes_; i++) {
-    fprintf(out, "%c%c", kHexBytes[this->bytes_[i] >> 4 & 0x0F],
-            kHexBytes[this->bytes_[i] & 0x0F]);
+    int byte = ByteAt(i, this);
+    fprintf(out, "%c%c", kHexBytes[byte >> 4 & 0x0F],
+            kHexBytes[byte & 0x0F]);
   }
 }
 
 void LargeUIntBase10Print(const LargeUInt* this, FILE* out) {
-  char str_buffer[BASE_10_LARGE_U_INT_BUFFER_SIZE];
-  LargeUIntBase10Store(this, BASE_10_LARGE_U_INT_BUFFER_SIZE, str_buffer);
+  int buffer_size = LargeUIntBase10BufferSize(this);
+  char* str_buffer = malloc(buffer_size);
+  if (str_buffer == NULL) {
+    ErrorOut("Unable to allocate space for base ten string.");
+  }
+  LargeUIntBase10Store(this, buffer_size, str_buffer);
   fprintf(out, "%s", str_buffer);
+  free(str_buffer);
+}
+
+int LargeUIntBase10BufferSize(const LargeUInt* this) {
+  // Each byte adds less than three decimal digits, with one more byte for
+  // the trailing null terminator. This should be a safe overestimate.
+  return this->num_bytes_ * 3 + 1;
 }
 
 // Processes one input character to set the value of this. Returns 1 to
@@ -78,6 +945,13 @@ static int ParseCharacter(int current, LargeUInt* this, int* state) {
   if (*state == -5) {  // Looking for the _ between num_bytes and byte values.
     if (current == '_') {
       *state = 0;  // Start looking for a byte's value.
+      // The byte values are or'ed in to the limbs as they are read.
+      int num_bytes = this->num_bytes_;
+      this->num_bytes_ = 0;
+      Resize(num_bytes, this);
+      if (num_bytes == 0) {
+        return 0;
+      }
     }
     return 1;
   }
@@ -107,15 +981,19 @@ static int ParseCharacter(int current, LargeUInt* this, int* state) {
       return 1;
   }
 
+  int byte_index = *state / 2;
+  int bit_offset = 8 * (byte_index % 8);
   if (*state % 2 == 0) {
-    this->bytes_[*state / 2] = current_value << 4;
-    (*state)++;  // Has read the upper nibble of the byte.
+    // The upper nibble of the byte.
+    this->limbs_[byte_index / 8] |=
+        (uint64_t)current_value << (bit_offset + 4);
+    (*state)++;
   } else {
-    this->bytes_[(*state - 1) / 2] += current_value;
+    this->limbs_[byte_index / 8] |= (uint64_t)current_value << bit_offset;
     (*state)++;
     if ((*state / 2) >= this->num_bytes_) {
       return 0;
-    } 
+    }
   }
   return 1;
 }
@@ -127,13 +1005,13 @@ void LargeUIntRead(FILE* in, LargeUInt* this) {
 
   int current = fgetc(in);
   int state = -1;  // start state
-  this->num_bytes_ = 0; 
+  this->num_bytes_ = 0;
 
   while (1) {
     if (feof(in)) {
       break;
     }
-    
+
     if (ParseCharacter(current, this, &state) == 0) {
       return;
     }
@@ -147,6 +1025,9 @@ int LargeUIntBufferSize(const LargeUInt* this) {
 }
 
 void LargeUIntStore(const LargeUInt* this, int buffer_size, char* buffer) {
+  if (this->num_bytes_ > MAX_NUM_LARGE_U_INT_BYTES) {
+    ErrorOut("Large integer is too big for the text format.");
+  }
   if (LargeUIntBufferSize(this) > buffer_size) {
     ErrorOut("Insufficient space for value in the provided buffer.");
   }
@@ -160,48 +1041,15 @@ void LargeUIntStore(const LargeUInt* this, int buffer_size, char* buffer) {
   int i = 0;
   int j = 5;
   for (; i < this->num_bytes_; i++) {
-    buffer[j] = kHexBytes[this->bytes_[i] >> 4 & 0x0F];
+    int byte = ByteAt(i, this);
+    buffer[j] = kHexBytes[byte >> 4 & 0x0F];
     j++;
-    buffer[j] = kHexBytes[this->bytes_[i] & 0x0F];
+    buffer[j] = kHexBytes[byte & 0x0F];
     j++;
   }
   buffer[j] = '\0';
 }
 
-void LargeUIntBase10Store(
-    const LargeUInt* this, int buffer_size, char* buffer) {
-  char internal_buffer[BASE_10_LARGE_U_INT_BUFFER_SIZE];
-  int num_digits = 0;
-  LargeUInt reduced_this;
-  LargeUInt quotient;
-  LargeUInt remainder;
-  LargeUInt ten;
-  ten.num_bytes_ = 1;
-  ten.bytes_[0] = 10;
-
-  LargeUIntDivide(this, &ten, &quotient, &remainder);
-  while (remainder.num_bytes_ > 0 || quotient.num_bytes_ > 0) {
-    if (remainder.num_bytes_ == 0) {
-      internal_buffer[num_digits] = 0;
-    } else {
-      internal_buffer[num_digits] = remainder.bytes_[0];
-    }
-    LargeUIntClone(&quotient, &reduced_this);
-    num_digits++;
-    LargeUIntDivide(&reduced_this, &ten, &quotient, &remainder);
-  }
-
-  if (num_digits > buffer_size - 1) {
-    ErrorOut("Insufficient space in buffer to store base ten string.");
-  }
-
-  int i;
-  for (i = 0; i < num_digits; i++) {
-    buffer[i] = '0' + internal_buffer[num_digits - i - 1];
-  }
-  buffer[i] = '\0';
-}
-
 void LargeUIntLoad(int buffer_size, char* buffer, LargeUInt* this) {
   if (buffer == NULL) {
     ErrorOut("Invalid input buffer, unable to load LargeUInt.");
@@ -217,23 +1065,41 @@ void LargeUIntLoad(int buffer_size, char* buffer, LargeUInt* this) {
 }
 
 void LargeUIntInit(int starting_size, LargeUInt* this) {
-  if (starting_size < 0 || starting_size > MAX_NUM_LARGE_U_INT_BYTES) {
+  if (starting_size < 0) {
     ErrorOut("Invalis size when initializing a large integer.");
   }
-  this->num_bytes_ = starting_size;
+  this->num_bytes_ = 0;
+  this->capacity_ = NUM_LARGE_U_INT_SMALL_LIMBS;
+  this->limbs_ = this->small_limbs_;
+  Resize(starting_size, this);
 }
 
-void LargeUIntGrow(LargeUInt* this) {
-  if (this->num_bytes_ == MAX_NUM_LARGE_U_INT_BYTES) {
-    ErrorOut("Unable to grow large integer.");
+void LargeUIntFree(LargeUInt* this) {
+  if (this->limbs_ != this->small_limbs_) {
+    PoolRelease(this->limbs_, this->capacity_);
   }
-  this->num_bytes_++;
+  this->num_bytes_ = 0;
+  this->capacity_ = NUM_LARGE_U_INT_SMALL_LIMBS;
+  this->limbs_ = this->small_limbs_;
+}
+
+void LargeUIntSetUInt64(uint64_t value, LargeUInt* this) {
+  this->num_bytes_ = 0;
+  Resize(8, this);
+  this->limbs_[0] = value;
+  LargeUIntTrim(this);
+}
+
+uint64_t LargeUIntGetUInt64(const LargeUInt* this) {
+  return this->num_bytes_ == 0 ? 0 : this->limbs_[0];
+}
+
+void LargeUIntGrow(LargeUInt* this) {
+  Resize(this->num_bytes_ + 1, this);
 }
 
 void LargeUIntTrim(LargeUInt* this) {
-  while (this->num_bytes_ > 0 && this->bytes_[this->num_bytes_ - 1] == 0) {
-    this->num_bytes_--;
-  }
+  this->num_bytes_ = SignificantBytes(this->limbs_, NumLimbs(this));
 }
 
 void LargeUIntSetByte(int value, int index, LargeUInt* this) {
@@ -243,14 +1109,16 @@ void LargeUIntSetByte(int value, int index, LargeUInt* this) {
   if (value < 0 || value > 255) {
     ErrorOut("Invalid value when setting byte.");
   }
-  this->bytes_[index] = value;
+  int bit_offset = 8 * (index % 8);
+  this->limbs_[index / 8] &= ~((uint64_t)0xFF << bit_offset);
+  this->limbs_[index / 8] |= (uint64_t)value << bit_offset;
 }
 
 int LargeUIntGetByte(int index, const LargeUInt* this) {
   if (index < 0 || index >= this->num_bytes_) {
     ErrorOut("Index out of bounds when getting byte.");
   }
-  return this->bytes_[index];
+  return ByteAt(index, this);
 }
 
 int LargeUIntNumBytes(const LargeUInt* this) {
@@ -258,22 +1126,16 @@ int LargeUIntNumBytes(const LargeUInt* this) {
 }
 
 int LargeUIntCompare(const LargeUInt* this, const LargeUInt* that) {
-  if (this->num_bytes_ > that->num_bytes_) {
+  // Leading zero limbs do not change the value.
+  int this_limbs = TrimmedLimbs(this);
+  int that_limbs = TrimmedLimbs(that);
+  if (this_limbs > that_limbs) {
     return -1;
-  } else if (this->num_bytes_ < that->num_bytes_) {
+  } else if (this_limbs < that_limbs) {
     return 1;
-  } else {
-    int i;
-    // Start with the most significant byte.
-    for (i = this->num_bytes_ - 1; i >= 0; i--) {
-      if (this->bytes_[i] > that->bytes_[i]) {
-        return -1;
-      } else if (this->bytes_[i] < that->bytes_[i]) {
-        return 1;
-      }
-    }
   }
-  return 0;
+  // Start with the most significant limb.
+  return CompareLimbs(this->limbs_, that->limbs_, this_limbs);
 }
 
 int LargeUIntLessThan(const LargeUInt* this, const LargeUInt* that) {
@@ -289,20 +1151,18 @@ int LargeUIntEqual(const LargeUInt* this, const LargeUInt* that) {
 }
 
 void LargeUIntClone(const LargeUInt* that, LargeUInt* this) {
+  if (this == that) {
+    return;
+  }
+  // Nothing in this needs to be kept while making room for the value.
+  this->num_bytes_ = 0;
+  Reserve(NumLimbs(that), this);
   this->num_bytes_ = that->num_bytes_;
-  memmove(this->bytes_, that->bytes_, this->num_bytes_);
+  memmove(this->limbs_, that->limbs_, NumLimbs(that) * sizeof(uint64_t));
 }
 
 void LargeUIntByteShiftInc(LargeUInt* this) {
-  if (this->num_bytes_ == MAX_NUM_LARGE_U_INT_BYTES) {
-    ErrorOut("Unable to byte shift large integer.");
-  }
-  int i;
-  for (i = this->num_bytes_; i > 0; i--) {
-    this->bytes_[i] = this->bytes_[i - 1];
-  }
-  this->num_bytes_++;
-  this->bytes_[0] = 0;
+  LargeUIntMultiByteShiftInc(1, this);
   LargeUIntTrim(this);
 }
 
@@ -311,90 +1171,75 @@ int LargeUIntByteShiftDec(LargeUInt* this) {
     ErrorOut("Unable to decrease shift an integer of zero.");
   }
 
-  int lowest_byte = this->bytes_[0];
-  int i;
-  for (i = 0; i < this->num_bytes_ - 1; i++) {
-    this->bytes_[i] = this->bytes_[i + 1];
-  }
-  this->num_bytes_--;
+  int lowest_byte = ByteAt(0, this);
+  LargeUIntMultiByteShiftDec(1, this);
   return lowest_byte;
 }
 
 void LargeUIntMultiByteShiftInc(int num_bytes, LargeUInt* this) {
-  if (this->num_bytes_ + num_bytes > MAX_NUM_LARGE_U_INT_BYTES) {
-    ErrorOut("Unable to byte shift large integer.");
-  }
   if (this->num_bytes_ == 0) {
     return;
   }
-  int i;
-  for (i = this->num_bytes_ - 1; i >= 0; i--) {
-    this->bytes_[i + num_bytes] = this->bytes_[i];
-  }
+  Reserve(LimbsForBytes(this->num_bytes_ + num_bytes), this);
+  int in_limbs = NumLimbs(this);
   this->num_bytes_ += num_bytes;
-  memset(this->bytes_, 0, num_bytes);
+  ShiftLimbsUp(this->limbs_, in_limbs, 8 * num_bytes,
+               this->limbs_, NumLimbs(this));
 }
 
 void LargeUIntMultiByteShiftDec(int num_bytes, LargeUInt* this) {
   if (this->num_bytes_ - num_bytes < 0) {
     ErrorOut("Unable to decrease shift an integer by this many bytes.");
   }
+  int in_limbs = NumLimbs(this);
   this->num_bytes_ -= num_bytes;
+  ShiftLimbsDown(this->limbs_, in_limbs, 8 * num_bytes,
+                 this->limbs_, NumLimbs(this));
+}
+
+void LargeUIntAdd(const LargeUInt* that, LargeUInt* this) {
+  int that_limbs = NumLimbs(that);
+  int num_bytes = this->num_bytes_ > that->num_bytes_ ?
+      this->num_bytes_ : that->num_bytes_;
+  // Leave room for a carry into one more byte.
+  Resize(num_bytes + 1, this);
+
+  uint64_t carry = 0;
+  unsigned __int128 sum;
   int i;
-  for (i = 0; i < this->num_bytes_; i++) {
-    this->bytes_[i] = this->bytes_[i + num_bytes];
-  }
-}
-
-void LargeUIntAdd(const LargeUInt* that, LargeUInt* this) {
-  int carry = 0;
-  int value = 0;
-  for (int i = 0; i < this->num_bytes_ || i < that->num_bytes_; i++) {
-    if (i >= this->num_bytes_) {
-      value = that->bytes_[i] + carry;
-      LargeUIntGrow(this);
-    } else if (i < that->num_bytes_) {
-      value = this->bytes_[i] + that->bytes_[i] + carry;
-    } else if (carry > 0) {
-      value = this->bytes_[i] + carry;
-    } else {
-      value = this->bytes_[i];
-    }
-    if (value > 255) {
-      value -= 256;
-      carry = 1;
-    } else {
-      carry = 0;
-    }
-    this->bytes_[i] = value;
-    value = 0;
-  }
-  if (carry > 0) {
-    LargeUIntGrow(this);
-    this->bytes_[this->num_bytes_ - 1] = carry;
+  for (i = 0; i < that_limbs; i++) {
+    sum = (unsigned __int128)this->limbs_[i] + that->limbs_[i] + carry;
+    this->limbs_[i] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
+  }
+  for (; i < NumLimbs(this) && carry; i++) {
+    this->limbs_[i]++;
+    carry = this->limbs_[i] == 0;
+  }
+  if (SignificantBytes(this->limbs_, NumLimbs(this)) > num_bytes) {
+    num_bytes++;
   }
+  this->num_bytes_ = num_bytes;
 }
 
 void LargeUIntAddByte(int byte, LargeUInt* this) {
   if (byte < 0 || byte > 255) {
     ErrorOut("Byte value in addition should be between 0 and 255.");
   }
-  int carry = byte;
-  int value = 0;
-  for (int i = 0; i < this->num_bytes_ && carry > 0; i++) {
-    value = this->bytes_[i] + carry;
-    if (value > 255) {
-      value -= 256;
-      carry = 1;
-    } else {
-      carry = 0;
-    }
-    this->bytes_[i] = value;
+  int num_bytes = this->num_bytes_;
+  // Leave room for a carry into one more byte.
+  Resize(num_bytes + 1, this);
+
+  uint64_t carry = byte;
+  int i;
+  for (i = 0; i < NumLimbs(this) && carry > 0; i++) {
+    this->limbs_[i] += carry;
+    carry = this->limbs_[i] < carry;
   }
-  if (carry == 1) {
-    LargeUIntGrow(this);
-    this->bytes_[this->num_bytes_ - 1] = carry;
+  if (SignificantBytes(this->limbs_, NumLimbs(this)) > num_bytes) {
+    num_bytes++;
   }
+  this->num_bytes_ = num_bytes;
 }
 
 void LargeUIntIncrement(LargeUInt* this) {
@@ -404,132 +1249,281 @@ void LargeUIntIncrement(LargeUInt* this) {
 void LargeUIntSub(const LargeUInt* that, LargeUInt* this) {
   int diff = LargeUIntCompare(that, this);
   if (diff == 0) {
-    LargeUIntInit(0, this);
+    // Keep the storage, which may have come from the pool.
+    this->num_bytes_ = 0;
     return;
   } else if (diff < 0) {
     ErrorOut("Subtraction would have caused a negative value.");
   }
 
-  // We now know that this is larger than that.
-  int borrow = 0;
-  int value = 0;
-  for (int i = 0; i < this->num_bytes_; i++) {
-    if (i < that->num_bytes_) {
-      value = this->bytes_[i] - that->bytes_[i] - borrow;
-    } else {
-      value = this->bytes_[i] - borrow;
-    }
-    if (value < 0) {
-      value += 256;
-      borrow = 1;
-    } else {
-      borrow = 0;
-    }
-    this->bytes_[i] = value;
-  }
-  while (this->num_bytes_ > 0 && this->bytes_[this->num_bytes_ - 1] == 0) {
-    this->num_bytes_--;
+  // We now know that this is larger than that, so the top limbs of that
+  // which are past the end of this must be zero.
+  int that_limbs = NumLimbs(that);
+  if (that_limbs > NumLimbs(this)) {
+    that_limbs = NumLimbs(this);
   }
+  SubLimbs(that->limbs_, that_limbs, this->limbs_, NumLimbs(this));
+  LargeUIntTrim(this);
 }
 
 void LargeUIntDecrement(LargeUInt* this) {
-  while (this->num_bytes_ > 0 && this->bytes_[this->num_bytes_ - 1] == 0) {
-    this->num_bytes_--;
-  }
+  LargeUIntTrim(this);
   if (this->num_bytes_ == 0) {
     ErrorOut("Unable to decrement an integer of value 0.");
   }
 
-  int borrow = 1;
-  int value = 0;
-  for (int i = 0; i < this->num_bytes_ && borrow == 1; i++) {
-    value = this->bytes_[i] - borrow;
-    if (value < 0) {
-      value += 256;
-      borrow = 1;
-    } else {
-      borrow = 0;
+  uint64_t one = 1;
+  SubLimbs(&one, 1, this->limbs_, NumLimbs(this));
+  LargeUIntTrim(this);
+}
+
+void LargeUIntMultiply(const LargeUInt* that, LargeUInt* this) {
+  // The product is formed in a temporary so that that and this may be the
+  // same integer.
+  LargeUInt product;
+  LargeUIntInit(0, &product);
+  LargeUIntProduct(that, this, &product);
+  LargeUIntClone(&product, this);
+  LargeUIntFree(&product);
+}
+
+void LargeUIntProduct(const LargeUInt* a, const LargeUInt* b,
+                      LargeUInt* product) {
+  if (product == a || product == b) {
+    ErrorOut("Product must not share storage with a factor.");
+  }
+  int a_limbs = TrimmedLimbs(a);
+  int b_limbs = TrimmedLimbs(b);
+  product->num_bytes_ = 0;
+  if (a_limbs == 0 || b_limbs == 0) {
+    return;
+  }
+  Resize(8 * (a_limbs + b_limbs), product);
+  if (a == b) {
+    MultiplyBalanced(a->limbs_, a->limbs_, a_limbs, product->limbs_);
+  } else if (a_limbs >= b_limbs) {
+    MultiplyUnbalanced(a->limbs_, a_limbs, b->limbs_, b_limbs,
+                       product->limbs_);
+  } else {
+    MultiplyUnbalanced(b->limbs_, b_limbs, a->limbs_, a_limbs,
+                       product->limbs_);
+  }
+  LargeUIntTrim(product);
+}
+
+void LargeUIntSquare(const LargeUInt* that, LargeUInt* this) {
+  LargeUIntProduct(that, that, this);
+}
+
+void LargeUIntSetMultiplyThresholds(int karatsuba_limbs, int toom_3_limbs,
+                                    int ntt_limbs) {
+  // Karatsuba needs at least two limbs in each half and Toom-Cook 3 needs at
+  // least one limb in the high part.
+  if (karatsuba_limbs < 4) {
+    karatsuba_limbs = 4;
+  }
+  if (toom_3_limbs < 9) {
+    toom_3_limbs = 9;
+  }
+  if (toom_3_limbs < karatsuba_limbs) {
+    toom_3_limbs = karatsuba_limbs;
+  }
+  if (ntt_limbs < 1) {
+    ntt_limbs = 1;
+  }
+  karatsuba_threshold = karatsuba_limbs;
+  toom_3_threshold = toom_3_limbs;
+  ntt_threshold = ntt_limbs;
+}
+
+// Finds the reciprocal of a normalized divisor, floor((B^2 - 1) / d) - B
+// with B = 2^64, for use with DivideTwoByOne.
+static uint64_t Reciprocal(uint64_t d) {
+  return (uint64_t)((((unsigned __int128)~d << 64) | ~(uint64_t)0) / d);
+}
+
+// Divides the two limb value u1:u0 by a normalized divisor d, given its
+// reciprocal v and u1 < d. The quotient is returned and the remainder stored.
+// This is the 2-by-1 division of Moller and Granlund, "Improved division by
+// invariant integers", which replaces the hardware divide with a multiply
+// and a couple of adjustments.
+static uint64_t DivideTwoByOne(uint64_t u1, uint64_t u0, uint64_t d,
+                               uint64_t v, uint64_t* remainder) {
+  unsigned __int128 q = (unsigned __int128)v * u1 +
+                        (((unsigned __int128)(u1 + 1) << 64) | u0);
+  uint64_t q1 = (uint64_t)(q >> 64);
+  uint64_t q0 = (uint64_t)q;
+  uint64_t r = u0 - q1 * d;
+  if (r > q0) {
+    q1--;
+    r += d;
+  }
+  if (r >= d) {
+    q1++;
+    r -= d;
+  }
+  *remainder = r;
+  return q1;
+}
+
+// Divides the limbs of u by a single limb, storing the quotient limbs in q
+// when q is not NULL. The remainder is returned. Both values are shifted up
+// so the divisor's top bit is set, which leaves the quotient unchanged and
+// shifts the remainder up by the same amount.
+static uint64_t DivideLimbsBySingle(const uint64_t* u, int u_limbs,
+                                    uint64_t d, uint64_t* q) {
+  int shift = __builtin_clzll(d);
+  d <<= shift;
+  uint64_t v = Reciprocal(d);
+  uint64_t remainder = 0;
+  uint64_t digit;
+  if (shift > 0) {
+    remainder = u[u_limbs - 1] >> (64 - shift);
+  }
+  int i;
+  for (i = u_limbs - 1; i >= 0; i--) {
+    uint64_t limb = u[i] << shift;
+    if (shift > 0 && i > 0) {
+      limb |= u[i - 1] >> (64 - shift);
+    }
+    digit = DivideTwoByOne(remainder, limb, d, v, &remainder);
+    if (q != NULL) {
+      q[i] = digit;
     }
-    this->bytes_[i] = value;
   }
+  return remainder >> shift;
+}
 
-  while (this->num_bytes_ > 0 && this->bytes_[this->num_bytes_ - 1] == 0) {
-    this->num_bytes_--;
+// Knuth's Algorithm D (The Art of Computer Programming, volume 2, section
+// 4.3.1). The divisor is shifted so its top bit is set, which lets each
+// quotient limb be estimated from the top two limbs of the running remainder
+// and corrected with the next limb down. The estimate is then at most one too
+// large, which is fixed by adding the divisor back in the rare case that the
+// subtraction borrows. u has u_limbs + 1 limbs with u[u_limbs] zero on entry
+// and is replaced by the remainder. d has d_limbs limbs, at least two, and
+// is normalized in place. The quotient limbs are stored in q unless it is
+// NULL.
+static void DivideLimbsKnuth(uint64_t* u, int u_limbs,
+                             uint64_t* d, int d_limbs, uint64_t* q) {
+  int shift = __builtin_clzll(d[d_limbs - 1]);
+  ShiftLimbsUp(d, d_limbs, shift, d, d_limbs);
+  ShiftLimbsUp(u, u_limbs + 1, shift, u, u_limbs + 1);
+
+  uint64_t d_high = d[d_limbs - 1];
+  uint64_t d_next = d[d_limbs - 2];
+  int j;
+  for (j = u_limbs - d_limbs; j >= 0; j--) {
+    uint64_t* window = u + j;
+    unsigned __int128 top = ((unsigned __int128)window[d_limbs] << 64) |
+                            window[d_limbs - 1];
+    unsigned __int128 q_hat = top / d_high;
+    unsigned __int128 r_hat = top - q_hat * d_high;
+    while ((q_hat >> 64) != 0 ||
+           q_hat * d_next > ((r_hat << 64) | window[d_limbs - 2])) {
+      q_hat--;
+      r_hat += d_high;
+      if ((r_hat >> 64) != 0) {
+        break;
+      }
+    }
+
+    // Subtract q_hat times the divisor from the window.
+    uint64_t digit = (uint64_t)q_hat;
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    int i;
+    for (i = 0; i < d_limbs; i++) {
+      unsigned __int128 product = (unsigned __int128)digit * d[i] + carry;
+      carry = (uint64_t)(product >> 64);
+      unsigned __int128 diff = (unsigned __int128)window[i] -
+                               (uint64_t)product - borrow;
+      window[i] = (uint64_t)diff;
+      borrow = (uint64_t)(diff >> 64) & 1;
+    }
+    unsigned __int128 diff = (unsigned __int128)window[d_limbs] - carry -
+                             borrow;
+    window[d_limbs] = (uint64_t)diff;
+
+    if ((uint64_t)(diff >> 64) & 1) {
+      // The estimate was one too large.
+      digit--;
+      window[d_limbs] += AddLimbs(d, d_limbs, window, d_limbs);
+    }
+    if (q != NULL) {
+      q[j] = digit;
+    }
   }
+
+  ShiftLimbsDown(u, d_limbs, shift, u, d_limbs);
 }
 
-void LargeUIntMultiply(const LargeUInt* that, LargeUInt* this) {
-  // Multiply by zero sets this to zero.
-  if (that->num_bytes_ == 0) {
-    this->num_bytes_ = 0;
+// Long division over the limbs. The quotient may be NULL if only the
+// remainder is needed, in which case no space is set aside for it.
+static void DivideLimbs(const LargeUInt* numerator,
+                        const LargeUInt* denominator,
+                        LargeUInt* quotient, LargeUInt* remainder) {
+  int num_limbs = TrimmedLimbs(numerator);
+  int den_limbs = TrimmedLimbs(denominator);
+  if (den_limbs == 0) {
+    ErrorOut("Unable to divide by zero.");
   }
 
-  // Multiplied based on repeated additions. Inefficient, but easy to verify.
-  LargeUInt value;
-  LargeUIntClone(this, &value);
+  if (num_limbs < den_limbs) {
+    LargeUIntClone(numerator, remainder);
+    LargeUIntTrim(remainder);
+    if (quotient != NULL) {
+      quotient->num_bytes_ = 0;
+    }
+    return;
+  }
 
-  LargeUInt additions;
-  LargeUIntClone(that, &additions);
-  // Decrement since this is already value multiplied by one.
-  LargeUIntDecrement(&additions);
+  // The working copies come from the pool so that the results may share
+  // storage with the inputs.
+  int u_capacity;
+  int d_capacity;
+  int q_capacity = 0;
+  uint64_t* u = PoolAlloc(num_limbs + 1, &u_capacity);
+  uint64_t* d = PoolAlloc(den_limbs, &d_capacity);
+  uint64_t* q = NULL;
+  int q_limbs = num_limbs - den_limbs + 1;
+  if (quotient != NULL) {
+    q = PoolAlloc(q_limbs, &q_capacity);
+  }
+  memcpy(u, numerator->limbs_, num_limbs * sizeof(uint64_t));
+  u[num_limbs] = 0;
+  memcpy(d, denominator->limbs_, den_limbs * sizeof(uint64_t));
 
-  while(additions.num_bytes_ > 0) {
-    LargeUIntDecrement(&additions);
-    LargeUIntAdd(&value, this);
+  if (den_limbs == 1) {
+    u[0] = DivideLimbsBySingle(u, num_limbs, d[0], q);
+  } else {
+    DivideLimbsKnuth(u, num_limbs, d, den_limbs, q);
+  }
+
+  if (quotient != NULL) {
+    quotient->num_bytes_ = 0;
+    Resize(8 * q_limbs, quotient);
+    memcpy(quotient->limbs_, q, q_limbs * sizeof(uint64_t));
+    LargeUIntTrim(quotient);
+    PoolRelease(q, q_capacity);
   }
+  remainder->num_bytes_ = 0;
+  Resize(8 * den_limbs, remainder);
+  memcpy(remainder->limbs_, u, den_limbs * sizeof(uint64_t));
+  LargeUIntTrim(remainder);
+
+  PoolRelease(u, u_capacity);
+  PoolRelease(d, d_capacity);
 }
 
 void LargeUIntDivide(const LargeUInt* numerator, const LargeUInt* denominator,
                      LargeUInt* quotient, LargeUInt* remainder) {
-  quotient->num_bytes_ = 0;
   if (numerator->num_bytes_ == 0) {
+    quotient->num_bytes_ = 0;
     remainder->num_bytes_ = 0;
     return;
   }
 
-  // The remainder starts out with the full value of the numerator.
-  LargeUIntClone(numerator, remainder);
-
-  LargeUInt repeated_divisor;
-  LargeUIntClone(denominator, &repeated_divisor);
-
-  LargeUInt quotient_segment;
-  int divisor_shifts;
-  int i;
-
-  while (LargeUIntLessThanOrEqual(denominator, remainder)) {
-    divisor_shifts = 0;
-    // We byte shift the divisor until it has the same number of bytes as
-    // the amount that we still have left from the numerator.
-    divisor_shifts = remainder->num_bytes_ - repeated_divisor.num_bytes_;
-    LargeUIntMultiByteShiftInc(divisor_shifts, &repeated_divisor);
-    // If using the same number of bytes means that we have multiplied the
-    // divisor too many times, backtrack on one of the shifts.
-    if (LargeUIntLessThan(remainder, &repeated_divisor)) {
-      divisor_shifts--;
-      LargeUIntByteShiftDec(&repeated_divisor);
-    }
-    // We translate the number of byte shifts performed into the number that
-    // we have multiplied the divisor by, to store in the quotient.
-    quotient_segment.num_bytes_ = 1;
-    quotient_segment.bytes_[0] = 0;
-    // Subtract the multiplied divisor into what is left of the numerator as
-    // many times as is possible while having a remainder left over.
-    while (LargeUIntLessThanOrEqual(&repeated_divisor, remainder)) {
-      LargeUIntSub(&repeated_divisor, remainder);
-      LargeUIntIncrement(&quotient_segment);
-    }
-    // Reset the divisor to determine the next round of multiplications that
-    // can fit in the remainder left from this round.
-    LargeUIntClone(denominator, &repeated_divisor);
-
-    // Add the number of subtractions at the correct byte in the quotient.
-    LargeUIntMultiByteShiftInc(divisor_shifts, &quotient_segment);
-    LargeUIntAdd(&quotient_segment, quotient);
-  }
-
-  LargeUIntTrim(quotient);
-  LargeUIntTrim(remainder);
+  DivideLimbs(numerator, denominator, quotient, remainder);
 }
 
 void LargeUIntMod(const LargeUInt* numerator, const LargeUInt* divisor,
@@ -539,64 +1533,903 @@ void LargeUIntMod(const LargeUInt* numerator, const LargeUInt* divisor,
     return;
   }
 
-  LargeUIntClone(numerator, remainder);
+  DivideLimbs(numerator, divisor, NULL, remainder);
+}
+
+uint64_t LargeUIntModSmall(const LargeUInt* numerator, uint64_t divisor) {
+  if (divisor == 0) {
+    ErrorOut("Unable to divide by zero.");
+  }
+  int num_limbs = TrimmedLimbs(numerator);
+  if (num_limbs == 0) {
+    return 0;
+  }
+  if (num_limbs == 1) {
+    return numerator->limbs_[0] % divisor;
+  }
+  return DivideLimbsBySingle(numerator->limbs_, num_limbs, divisor, NULL);
+}
 
-  LargeUInt repeated_divisor;
-  LargeUIntClone(divisor, &repeated_divisor);
-  while (LargeUIntLessThanOrEqual(divisor, remainder)) {
-    int bytes_diff = remainder->num_bytes_ - repeated_divisor.num_bytes_ - 1;
-    if (bytes_diff >= 1) {
-      LargeUIntMultiByteShiftInc(bytes_diff, &repeated_divisor);
+// Decimal text is converted in chunks of 19 digits, the largest power of ten
+// which fits in a limb.
+#define BASE_10_CHUNK_DIGITS 19
+#define BASE_10_CHUNK 10000000000000000000ULL
+
+// Values with more limbs than this are split in two by a power of ten, so
+// each half can use the faster multiplication and division of smaller values.
+#define BASE_10_SPLIT_LIMBS 32
+#define MAX_BASE_10_POWERS 32
+
+// base_10_powers[i] holds 10^(19 * 2^i). They are filled in as larger values
+// are converted and kept for later conversions.
+static __thread LargeUInt base_10_powers[MAX_BASE_10_POWERS];
+static __thread int num_base_10_powers;
+
+static const LargeUInt* Base10Power(int index) {
+  while (num_base_10_powers <= index) {
+    LargeUInt* power = &base_10_powers[num_base_10_powers];
+    LargeUIntInit(0, power);
+    if (num_base_10_powers == 0) {
+      LargeUIntSetUInt64(BASE_10_CHUNK, power);
+    } else {
+      LargeUIntSquare(&base_10_powers[num_base_10_powers - 1], power);
     }
-    while (LargeUIntLessThanOrEqual(&repeated_divisor, remainder)) {
-      LargeUIntSub(&repeated_divisor, remainder);
+    num_base_10_powers++;
+  }
+  return &base_10_powers[index];
+}
+
+// Picks the power of ten to split num_digits digits by, 10^(19 * 2^level).
+// It is the smallest such power which leaves at least half of the digits in
+// the low part.
+static int Base10SplitLevel(int num_digits) {
+  int level = 0;
+  while ((BASE_10_CHUNK_DIGITS << (level + 1)) < num_digits) {
+    level++;
+  }
+  return level;
+}
+
+// Writes the value, which must be below 10^num_digits, as exactly num_digits
+// decimal digits with leading zeroes. Small values have 19 digits at a time
+// peeled off the bottom by single limb division.
+static void StoreDigits(const LargeUInt* value, int num_digits, char* digits) {
+  int num_limbs = TrimmedLimbs(value);
+  if (num_limbs <= BASE_10_SPLIT_LIMBS) {
+    uint64_t limbs[BASE_10_SPLIT_LIMBS];
+    memcpy(limbs, value->limbs_, num_limbs * sizeof(uint64_t));
+    int end = num_digits;
+    while (end > 0) {
+      uint64_t chunk = 0;
+      if (num_limbs > 0) {
+        chunk = DivideLimbsBySingle(limbs, num_limbs, BASE_10_CHUNK, limbs);
+        if (limbs[num_limbs - 1] == 0) {
+          num_limbs--;
+        }
+      }
+      int i;
+      for (i = 0; i < BASE_10_CHUNK_DIGITS && end > 0; i++) {
+        end--;
+        digits[end] = '0' + chunk % 10;
+        chunk /= 10;
+      }
     }
-    LargeUIntClone(divisor, &repeated_divisor);
+    return;
   }
 
-  LargeUIntTrim(remainder);
+  int level = Base10SplitLevel(num_digits);
+  int low_digits = BASE_10_CHUNK_DIGITS << level;
+  LargeUInt high;
+  LargeUInt low;
+  LargeUIntInit(0, &high);
+  LargeUIntInit(0, &low);
+  LargeUIntDivide(value, Base10Power(level), &high, &low);
+  StoreDigits(&high, num_digits - low_digits, digits);
+  StoreDigits(&low, low_digits, digits + num_digits - low_digits);
+  LargeUIntFree(&high);
+  LargeUIntFree(&low);
 }
 
-void LargeUIntApproximateSquareRoot(const LargeUInt* this, LargeUInt* root) {
-  LargeUInt two;
-  two.num_bytes_ = 1;
-  two.bytes_[0] = 2;
+void LargeUIntBase10Store(
+    const LargeUInt* this, int buffer_size, char* buffer) {
+  int num_bits = BitLength(this);
+  if (num_bits == 0) {
+    if (buffer_size < 1) {
+      ErrorOut("Insufficient space in buffer to store base ten string.");
+    }
+    buffer[0] = '\0';
+    return;
+  }
 
-  LargeUInt remainder;
-  LargeUInt estimate;
-  // Start by using an estimate of just above half of the input.
-  LargeUIntDivide(this, &two, &estimate, &remainder);
-  LargeUIntIncrement(&estimate);
+  // A value below 2^num_bits has at most num_bits * log10(2) + 1 digits.
+  // The estimate can be one too many, which shows up as a leading zero.
+  int num_digits = (int)((int64_t)num_bits * 30103 / 100000) + 1;
+  char* digits = malloc(num_digits);
+  if (digits == NULL) {
+    ErrorOut("Unable to allocate space for base ten string.");
+  }
+  StoreDigits(this, num_digits, digits);
+
+  int first = 0;
+  while (digits[first] == '0') {
+    first++;
+  }
+  if (num_digits - first > buffer_size - 1) {
+    ErrorOut("Insufficient space in buffer to store base ten string.");
+  }
+  memcpy(buffer, digits + first, num_digits - first);
+  buffer[num_digits - first] = '\0';
+  free(digits);
+}
+
+// Sets this to the value of a run of decimal digits. Short runs are gathered
+// 19 digits at a time with a single limb multiply, while long runs are split
+// in two and joined with a multiplication by a power of ten.
+static void LoadDigits(const char* digits, int num_digits, LargeUInt* this) {
+  if (num_digits <= BASE_10_SPLIT_LIMBS * BASE_10_CHUNK_DIGITS) {
+    int max_limbs = num_digits / BASE_10_CHUNK_DIGITS + 1;
+    this->num_bytes_ = 0;
+    Resize(8 * max_limbs, this);
+    int num_limbs = 0;
+    int start = 0;
+    int chunk_length = num_digits % BASE_10_CHUNK_DIGITS;
+    if (chunk_length == 0) {
+      chunk_length = BASE_10_CHUNK_DIGITS;
+    }
+    while (start < num_digits) {
+      uint64_t carry = 0;
+      int i;
+      for (i = 0; i < chunk_length; i++) {
+        carry = carry * 10 + (digits[start + i] - '0');
+      }
+      start += chunk_length;
+      chunk_length = BASE_10_CHUNK_DIGITS;
+
+      for (i = 0; i < num_limbs; i++) {
+        unsigned __int128 value =
+            (unsigned __int128)this->limbs_[i] * BASE_10_CHUNK + carry;
+        this->limbs_[i] = (uint64_t)value;
+        carry = (uint64_t)(value >> 64);
+      }
+      if (carry != 0) {
+        this->limbs_[num_limbs] = carry;
+        num_limbs++;
+      }
+    }
+    this->num_bytes_ = SignificantBytes(this->limbs_, num_limbs);
+    return;
+  }
+
+  int level = Base10SplitLevel(num_digits);
+  int low_digits = BASE_10_CHUNK_DIGITS << level;
+  LargeUInt low;
+  LargeUIntInit(0, &low);
+  LoadDigits(digits, num_digits - low_digits, this);
+  LargeUIntMultiply(Base10Power(level), this);
+  LoadDigits(digits + num_digits - low_digits, low_digits, &low);
+  LargeUIntAdd(&low, this);
+  LargeUIntTrim(this);
+  LargeUIntFree(&low);
+}
+
+void LargeUIntBase10Load(int buffer_size, char* buffer, LargeUInt* this) {
+  if (buffer == NULL) {
+    ErrorOut("Invalid input buffer, unable to load LargeUInt.");
+  }
+
+  int start = 0;
+  while (start < buffer_size && buffer[start] == ' ') {
+    start++;
+  }
+  int end = start;
+  while (end < buffer_size && buffer[end] >= '0' && buffer[end] <= '9') {
+    end++;
+  }
+  LoadDigits(buffer + start, end - start, this);
+}
 
-  LargeUInt quotient;
+void LargeUIntIsqrt(const LargeUInt* this, LargeUInt* root) {
+  int num_bits = BitLength(this);
+  if (num_bits == 0) {
+    LargeUIntSetUInt64(0, root);
+    return;
+  }
+
+  // Since this is below 2^num_bits, 2^ceil(num_bits / 2) is at least the
+  // square root. Newton's iteration falls monotonically from an overestimate
+  // and each step roughly doubles the number of correct bits, so only a few
+  // divisions are needed. The first estimate which fails to fall is the
+  // floor of the square root.
+  LargeUInt estimate;
   LargeUInt next_estimate;
-  next_estimate.num_bytes_ = 0;
+  LargeUInt remainder;
+  LargeUIntInit(0, &estimate);
+  LargeUIntInit(0, &next_estimate);
+  LargeUIntInit(0, &remainder);
+  int exponent = (num_bits + 1) / 2;
+  Resize(exponent / 8 + 1, &estimate);
+  estimate.limbs_[exponent / 64] = (uint64_t)1 << (exponent % 64);
 
-  int divided_evenly = 0;
-  int comparison;
   while (1) {
-    LargeUIntDivide(this, &estimate, &quotient, &remainder);
-    if (remainder.num_bytes_ == 0) {
-      divided_evenly = 1;
+    LargeUIntDivide(this, &estimate, &next_estimate, &remainder);
+    LargeUIntAdd(&estimate, &next_estimate);
+    int num_limbs = NumLimbs(&next_estimate);
+    ShiftLimbsDown(next_estimate.limbs_, num_limbs, 1,
+                   next_estimate.limbs_, num_limbs);
+    next_estimate.num_bytes_ =
+        SignificantBytes(next_estimate.limbs_, num_limbs);
+    if (!LargeUIntLessThan(&next_estimate, &estimate)) {
+      break;
+    }
+    LargeUIntClone(&next_estimate, &estimate);
+  }
+
+  LargeUIntClone(&estimate, root);
+  LargeUIntFree(&estimate);
+  LargeUIntFree(&next_estimate);
+  LargeUIntFree(&remainder);
+}
+
+void LargeUIntIsqrtUpdate(const LargeUInt* this, LargeUInt* root) {
+  LargeUInt next_root;
+  LargeUInt square;
+  LargeUIntInit(0, &next_root);
+  LargeUIntInit(0, &square);
+  LargeUIntClone(root, &next_root);
+  LargeUIntIncrement(&next_root);
+  LargeUIntSquare(&next_root, &square);
+  while (LargeUIntLessThanOrEqual(&square, this)) {
+    LargeUIntClone(&next_root, root);
+    LargeUIntIncrement(&next_root);
+    LargeUIntSquare(&next_root, &square);
+  }
+  LargeUIntFree(&next_root);
+  LargeUIntFree(&square);
+}
+
+void LargeUIntApproximateSquareRoot(const LargeUInt* this, LargeUInt* root) {
+  LargeUInt square;
+  LargeUIntInit(0, &square);
+  LargeUIntIsqrt(this, root);
+  LargeUIntSquare(root, &square);
+  if (!LargeUIntEqual(&square, this)) {
+    LargeUIntIncrement(root);
+  }
+  LargeUIntFree(&square);
+}
+
+void LargeUIntMontInit(const LargeUInt* modulus, LargeUIntMontCtx* ctx) {
+  int num_limbs = TrimmedLimbs(modulus);
+  if (num_limbs == 0 || (modulus->limbs_[0] & 1) == 0) {
+    ErrorOut("Montgomery modulus must be odd.");
+  }
+  ctx->num_limbs_ = num_limbs;
+  ctx->negative_inverse_ = NegativeInverse(modulus->limbs_[0]);
+  LargeUIntInit(0, &ctx->modulus_);
+  LargeUIntClone(modulus, &ctx->modulus_);
+  LargeUIntTrim(&ctx->modulus_);
+
+  // R^2 modulo the modulus converts values in to Montgomery form.
+  LargeUInt r_squared;
+  LargeUIntInit(16 * num_limbs + 1, &r_squared);
+  LargeUIntSetByte(1, 16 * num_limbs, &r_squared);
+  LargeUIntInit(0, &ctx->r_squared_);
+  LargeUIntMod(&r_squared, &ctx->modulus_, &ctx->r_squared_);
+  LargeUIntFree(&r_squared);
+}
+
+void LargeUIntMontFree(LargeUIntMontCtx* ctx) {
+  LargeUIntFree(&ctx->modulus_);
+  LargeUIntFree(&ctx->r_squared_);
+  ctx->num_limbs_ = 0;
+}
+
+// Copies a value below the modulus into num_limbs limbs, filling any missing
+// high limbs with zeroes.
+static void LoadMontLimbs(const LargeUInt* this, int num_limbs,
+                          uint64_t* limbs) {
+  int this_limbs = TrimmedLimbs(this);
+  if (this_limbs > num_limbs) {
+    ErrorOut("Montgomery operand must be less than the modulus.");
+  }
+  memcpy(limbs, this->limbs_, this_limbs * sizeof(uint64_t));
+  memset(limbs + this_limbs, 0, (num_limbs - this_limbs) * sizeof(uint64_t));
+}
+
+// Montgomery reduction of the 2n limb value in t, which has room for one
+// more limb. Each pass adds the multiple of the modulus which clears the
+// lowest limb, so after n passes the value divided by R is in the top half.
+// A final subtraction brings it below the modulus, and the result is stored.
+static void MontReduce(uint64_t* t, const LargeUIntMontCtx* ctx,
+                       LargeUInt* result) {
+  int n = ctx->num_limbs_;
+  const uint64_t* modulus = ctx->modulus_.limbs_;
+  t[2 * n] = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    uint64_t m = t[i] * ctx->negative_inverse_;
+    uint64_t carry = MultiplyAddLimb(modulus, n, m, t + i);
+    int j;
+    for (j = i + n; carry != 0 && j <= 2 * n; j++) {
+      t[j] += carry;
+      carry = t[j] < carry;
+    }
+  }
+
+  uint64_t* top = t + n;
+  if (top[n] != 0 || CompareLimbs(top, modulus, n) < 1) {
+    SubLimbs(modulus, n, top, n + 1);
+  }
+  result->num_bytes_ = 0;
+  Resize(8 * n, result);
+  memcpy(result->limbs_, top, n * sizeof(uint64_t));
+  LargeUIntTrim(result);
+}
+
+void LargeUIntMontMul(const LargeUInt* a, const LargeUInt* b,
+                      const LargeUIntMontCtx* ctx, LargeUInt* result) {
+  int n = ctx->num_limbs_;
+  int capacity;
+  uint64_t* scratch = PoolAlloc(4 * n + 1, &capacity);
+  uint64_t* a_limbs = scratch;
+  uint64_t* b_limbs = scratch + n;
+  uint64_t* t = scratch + 2 * n;
+  LoadMontLimbs(a, n, a_limbs);
+  if (a == b) {
+    MultiplyBalanced(a_limbs, a_limbs, n, t);
+  } else {
+    LoadMontLimbs(b, n, b_limbs);
+    MultiplyBalanced(a_limbs, b_limbs, n, t);
+  }
+  MontReduce(t, ctx, result);
+  PoolRelease(scratch, capacity);
+}
+
+void LargeUIntMontSqr(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                      LargeUInt* result) {
+  LargeUIntMontMul(a, a, ctx, result);
+}
+
+void LargeUIntToMont(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                     LargeUInt* result) {
+  if (LargeUIntLessThan(a, &ctx->modulus_)) {
+    LargeUIntMontMul(a, &ctx->r_squared_, ctx, result);
+  } else {
+    LargeUInt reduced;
+    LargeUIntInit(0, &reduced);
+    LargeUIntMod(a, &ctx->modulus_, &reduced);
+    LargeUIntMontMul(&reduced, &ctx->r_squared_, ctx, result);
+    LargeUIntFree(&reduced);
+  }
+}
+
+void LargeUIntFromMont(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                       LargeUInt* result) {
+  int n = ctx->num_limbs_;
+  int capacity;
+  uint64_t* t = PoolAlloc(2 * n + 1, &capacity);
+  LoadMontLimbs(a, n, t);
+  memset(t + n, 0, n * sizeof(uint64_t));
+  MontReduce(t, ctx, result);
+  PoolRelease(t, capacity);
+}
+
+// The largest window used by LargeUIntPowMod, and so the size of its table
+// of odd powers.
+#define MAX_POW_MOD_WINDOW 7
+#define POW_MOD_TABLE_SIZE (1 << (MAX_POW_MOD_WINDOW - 1))
+
+// LargeUIntPowMod keeps its Montgomery context and table of powers between
+// calls, so repeated exponentiations with the same modulus (as in primality
+// tests) skip the setup and reuse the table's storage.
+static __thread LargeUIntMontCtx pow_mod_ctx;
+static __thread int pow_mod_ctx_ready;
+static __thread LargeUInt pow_mod_table[POW_MOD_TABLE_SIZE];
+static __thread int pow_mod_table_ready;
+
+// Picks the window size which balances the cost of filling the table of odd
+// powers against the multiplications it saves.
+static int PowModWindow(int exponent_bits) {
+  if (exponent_bits < 8) {
+    return 1;
+  } else if (exponent_bits < 24) {
+    return 2;
+  } else if (exponent_bits < 80) {
+    return 3;
+  } else if (exponent_bits < 240) {
+    return 4;
+  } else if (exponent_bits < 672) {
+    return 5;
+  } else if (exponent_bits < 1792) {
+    return 6;
+  }
+  return MAX_POW_MOD_WINDOW;
+}
+
+// Multiplies a by b modulo the modulus. With a Montgomery context the values
+// are in Montgomery form, otherwise they are ordinary values.
+static void PowModMultiply(const LargeUInt* a, const LargeUInt* b,
+                           const LargeUIntMontCtx* ctx,
+                           const LargeUInt* modulus, LargeUInt* result) {
+  if (ctx != NULL) {
+    LargeUIntMontMul(a, b, ctx, result);
+  } else {
+    LargeUInt product;
+    LargeUIntInit(0, &product);
+    LargeUIntProduct(a, b, &product);
+    LargeUIntMod(&product, modulus, result);
+    LargeUIntFree(&product);
+  }
+}
+
+// Raises the base to the power of the exponent modulo the modulus with the
+// sliding window. With a Montgomery context for the modulus the result is
+// left in Montgomery form, otherwise it is an ordinary value.
+static void PowModInContext(const LargeUInt* base, const LargeUInt* exponent,
+                            const LargeUIntMontCtx* ctx,
+                            const LargeUInt* modulus, LargeUInt* result) {
+  int exponent_bits = BitLength(exponent);
+  int window = PowModWindow(exponent_bits);
+  int table_size = 1 << (window - 1);
+  for (; pow_mod_table_ready < table_size; pow_mod_table_ready++) {
+    LargeUIntInit(0, &pow_mod_table[pow_mod_table_ready]);
+  }
+
+  // The table holds the odd powers base^1, base^3, ... base^(2^window - 1).
+  LargeUInt accumulator;
+  LargeUInt base_squared;
+  LargeUIntInit(0, &accumulator);
+  LargeUIntInit(0, &base_squared);
+  if (ctx != NULL) {
+    LargeUIntToMont(base, ctx, &pow_mod_table[0]);
+  } else {
+    LargeUIntMod(base, modulus, &pow_mod_table[0]);
+  }
+  if (table_size > 1) {
+    PowModMultiply(&pow_mod_table[0], &pow_mod_table[0], ctx, modulus,
+                   &base_squared);
+  }
+  int i;
+  for (i = 1; i < table_size; i++) {
+    PowModMultiply(&pow_mod_table[i - 1], &base_squared, ctx, modulus,
+                   &pow_mod_table[i]);
+  }
+
+  // Scan the exponent from the top, squaring for each bit. Runs of bits which
+  // start and end with a one are handled with a single multiply from the
+  // table.
+  int started = 0;
+  i = exponent_bits - 1;
+  while (i >= 0) {
+    if (BitAt(i, exponent) == 0) {
+      PowModMultiply(&accumulator, &accumulator, ctx, modulus, &accumulator);
+      i--;
+      continue;
+    }
+    int low = i - window + 1 > 0 ? i - window + 1 : 0;
+    while (BitAt(low, exponent) == 0) {
+      low++;
+    }
+    int value = 0;
+    int j;
+    for (j = i; j >= low; j--) {
+      value = (value << 1) | BitAt(j, exponent);
+      if (started) {
+        PowModMultiply(&accumulator, &accumulator, ctx, modulus,
+                       &accumulator);
+      }
+    }
+    if (started) {
+      PowModMultiply(&accumulator, &pow_mod_table[value / 2], ctx, modulus,
+                     &accumulator);
     } else {
-      divided_evenly = 0;
+      LargeUIntClone(&pow_mod_table[value / 2], &accumulator);
+      started = 1;
+    }
+    i = low - 1;
+  }
+
+  if (started) {
+    LargeUIntClone(&accumulator, result);
+  } else {
+    // A zero exponent gives 1, or 0 when everything is 0 modulo 1.
+    int modulus_is_one = TrimmedLimbs(modulus) == 1 && modulus->limbs_[0] == 1;
+    LargeUIntSetUInt64(modulus_is_one ? 0 : 1, result);
+    if (ctx != NULL) {
+      LargeUIntToMont(result, ctx, result);
     }
-    LargeUIntAdd(&estimate, &quotient);
-    LargeUIntDivide(&quotient, &two, &next_estimate, &remainder);
+  }
+  LargeUIntFree(&accumulator);
+  LargeUIntFree(&base_squared);
+}
 
-    comparison = LargeUIntCompare(&next_estimate, &estimate);
-    if (comparison < 1) {
-      if (comparison < 0) {
-        divided_evenly = 0;
+void LargeUIntPowMod(const LargeUInt* base, const LargeUInt* exponent,
+                     const LargeUInt* modulus, LargeUInt* result) {
+  if (TrimmedLimbs(modulus) == 0) {
+    ErrorOut("Unable to divide by zero.");
+  }
+
+  // Odd moduli use Montgomery multiplication. Even moduli fall back to
+  // dividing after each product.
+  if (modulus->limbs_[0] & 1) {
+    if (!pow_mod_ctx_ready || !LargeUIntEqual(modulus, &pow_mod_ctx.modulus_)) {
+      if (pow_mod_ctx_ready) {
+        LargeUIntMontFree(&pow_mod_ctx);
       }
+      LargeUIntMontInit(modulus, &pow_mod_ctx);
+      pow_mod_ctx_ready = 1;
+    }
+    PowModInContext(base, exponent, &pow_mod_ctx, modulus, result);
+    LargeUIntFromMont(result, &pow_mod_ctx, result);
+  } else {
+    PowModInContext(base, exponent, NULL, modulus, result);
+  }
+}
+
+// The primes used for trial division and as deterministic Miller-Rabin bases.
+static const uint64_t kSmallPrimes[] = {
+  2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71,
+  73, 79, 83, 89, 97
+};
+#define NUM_SMALL_PRIMES ((int)(sizeof(kSmallPrimes) / sizeof(kSmallPrimes[0])))
+
+// Testing with the first 12 primes as bases gives the right answer for every
+// n below 2^64, and the first 13 primes for every n below
+// 3,317,044,064,679,887,385,961,981 (Sorenson and Webster, 2015).
+#define NUM_BASES_BELOW_2_64 12
+#define NUM_BASES_BELOW_2_81 13
+#define BASES_BOUND_HIGH 0x2BE69ULL
+#define BASES_BOUND_LOW 0x51ADC5B22410A5FDULL
+
+// One round of the strong probable prime test to the base, where
+// n - 1 = d * 2^s with d odd. Returns 1 if n passes. one and minus_one are 1
+// and n - 1 in Montgomery form.
+static int StrongProbablePrime(const LargeUInt* base, const LargeUInt* d,
+                               int s, const LargeUInt* n,
+                               const LargeUIntMontCtx* ctx,
+                               const LargeUInt* one,
+                               const LargeUInt* minus_one) {
+  // The power stays in Montgomery form, to compare with one and minus_one.
+  LargeUInt x;
+  LargeUIntInit(0, &x);
+  PowModInContext(base, d, ctx, n, &x);
+  int passes = LargeUIntEqual(&x, one) || LargeUIntEqual(&x, minus_one);
+  int i;
+  for (i = 1; i < s && !passes; i++) {
+    LargeUIntMontSqr(&x, ctx, &x);
+    if (LargeUIntEqual(&x, minus_one)) {
+      passes = 1;
+    } else if (LargeUIntEqual(&x, one)) {
+      // 1 was reached without passing through -1, so n is composite.
       break;
     }
+  }
+  LargeUIntFree(&x);
+  return passes;
+}
 
-    LargeUIntClone(&next_estimate, &estimate);
+// Settles small values and values with a factor up to 97. Returns 1 for a
+// prime, 0 for a composite and -1 if a probable prime test is needed.
+static int CheckSmallFactors(const LargeUInt* n) {
+  int num_limbs = TrimmedLimbs(n);
+  if (num_limbs == 0) {
+    return 0;
   }
+  int i;
+  for (i = 0; i < NUM_SMALL_PRIMES; i++) {
+    if (num_limbs == 1 && n->limbs_[0] == kSmallPrimes[i]) {
+      return 1;
+    }
+    if (LargeUIntModSmall(n, kSmallPrimes[i]) == 0) {
+      return 0;
+    }
+  }
+  if (num_limbs == 1 && n->limbs_[0] < 97 * 97) {
+    // No factor up to the square root, and 1 is not prime.
+    return n->limbs_[0] != 1;
+  }
+  return -1;
+}
 
-  LargeUIntClone(&estimate, root);
-  if (divided_evenly == 0) {
-    LargeUIntIncrement(root);
+// Runs the Miller-Rabin test on an odd n above 97 with num_bases bases. With
+// deterministic set the bases are the first small primes, otherwise base 2 is
+// followed by bases from a generator seeded from n.
+static int MillerRabin(const LargeUInt* n, int num_bases, int deterministic) {
+  int num_limbs = TrimmedLimbs(n);
+
+  // Write n - 1 as d * 2^s.
+  LargeUInt d;
+  LargeUIntInit(0, &d);
+  LargeUIntClone(n, &d);
+  LargeUIntDecrement(&d);
+  int s = 0;
+  while (BitAt(s, &d) == 0) {
+    s++;
+  }
+  ShiftLimbsDown(d.limbs_, NumLimbs(&d), s, d.limbs_, NumLimbs(&d));
+  LargeUIntTrim(&d);
+
+  LargeUIntMontCtx ctx;
+  LargeUInt one;
+  LargeUInt minus_one;
+  LargeUInt base;
+  LargeUInt n_minus_3;
+  LargeUIntMontInit(n, &ctx);
+  LargeUIntInit(0, &one);
+  LargeUIntInit(0, &minus_one);
+  LargeUIntInit(0, &base);
+  LargeUIntInit(0, &n_minus_3);
+  LargeUIntSetUInt64(1, &one);
+  LargeUIntToMont(&one, &ctx, &one);
+  LargeUIntClone(n, &minus_one);
+  LargeUIntSub(&one, &minus_one);
+  LargeUIntClone(n, &n_minus_3);
+  LargeUIntSetUInt64(3, &base);
+  LargeUIntSub(&base, &n_minus_3);
+
+  // Beyond the deterministic bounds, bases after 2 are picked from
+  // [2, n - 2] by a generator seeded from n, so results are repeatable.
+  uint64_t state = n->limbs_[0] ^ 0x9E3779B97F4A7C15ULL;
+  int is_probable_prime = 1;
+  int i;
+  for (i = 0; i < num_bases && is_probable_prime; i++) {
+    if (deterministic || i == 0) {
+      LargeUIntSetUInt64(kSmallPrimes[i], &base);
+    } else {
+      base.num_bytes_ = 0;
+      Resize(8 * num_limbs, &base);
+      int j;
+      for (j = 0; j < num_limbs; j++) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        base.limbs_[j] = state * 0x2545F4914F6CDD1DULL;
+      }
+      LargeUIntMod(&base, &n_minus_3, &base);
+      LargeUIntAddByte(2, &base);
+    }
+    is_probable_prime = StrongProbablePrime(&base, &d, s, n, &ctx, &one,
+                                            &minus_one);
+  }
+
+  LargeUIntMontFree(&ctx);
+  LargeUIntFree(&d);
+  LargeUIntFree(&one);
+  LargeUIntFree(&minus_one);
+  LargeUIntFree(&base);
+  LargeUIntFree(&n_minus_3);
+  return is_probable_prime;
+}
+
+int LargeUIntIsProbablePrime(const LargeUInt* n, int rounds) {
+  int small_factors = CheckSmallFactors(n);
+  if (small_factors != -1) {
+    return small_factors;
+  }
+
+  int num_limbs = TrimmedLimbs(n);
+  if (num_limbs == 1) {
+    return MillerRabin(n, NUM_BASES_BELOW_2_64, 1);
+  } else if (num_limbs == 2 &&
+             (n->limbs_[1] < BASES_BOUND_HIGH ||
+              (n->limbs_[1] == BASES_BOUND_HIGH &&
+               n->limbs_[0] < BASES_BOUND_LOW))) {
+    return MillerRabin(n, NUM_BASES_BELOW_2_81, 1);
+  }
+  return MillerRabin(n, rounds < 1 ? 1 : rounds, 0);
+}
+
+// The Jacobi symbol (a / m) for word sized a and odd m, using the binary
+// method which pulls out factors of 2 and flips the pair with quadratic
+// reciprocity.
+static int JacobiWord(uint64_t a, uint64_t m) {
+  int result = 1;
+  a %= m;
+  while (a != 0) {
+    while ((a & 1) == 0) {
+      a >>= 1;
+      if ((m & 7) == 3 || (m & 7) == 5) {
+        result = -result;
+      }
+    }
+    uint64_t swap = a;
+    a = m;
+    m = swap;
+    if ((a & 3) == 3 && (m & 3) == 3) {
+      result = -result;
+    }
+    a %= m;
+  }
+  return m == 1 ? result : 0;
+}
+
+int LargeUIntJacobi(int64_t a, const LargeUInt* n) {
+  if (n->num_bytes_ == 0 || (n->limbs_[0] & 1) == 0) {
+    ErrorOut("The Jacobi symbol needs an odd denominator.");
+  }
+  int n_is_one = TrimmedLimbs(n) == 1 && n->limbs_[0] == 1;
+  uint64_t n_mod_8 = n->limbs_[0] & 7;
+  int result = 1;
+  uint64_t x = (uint64_t)a;
+  if (a < 0) {
+    x = -x;
+    // (-1 / n) is -1 exactly when n is 3 modulo 4.
+    if ((n_mod_8 & 3) == 3) {
+      result = -result;
+    }
+  }
+  if (x == 0) {
+    return n_is_one ? 1 : 0;
+  }
+  while ((x & 1) == 0) {
+    x >>= 1;
+    if (n_mod_8 == 3 || n_mod_8 == 5) {
+      result = -result;
+    }
+  }
+  if (x == 1) {
+    return result;
+  }
+  // Quadratic reciprocity reduces the large value modulo the small one.
+  if ((x & 3) == 3 && (n_mod_8 & 3) == 3) {
+    result = -result;
+  }
+  return result * JacobiWord(LargeUIntModSmall(n, x), x);
+}
+
+// Modular addition, subtraction and halving for values below n.
+static void ModAdd(const LargeUInt* a, const LargeUInt* n, LargeUInt* this) {
+  LargeUIntAdd(a, this);
+  if (LargeUIntLessThanOrEqual(n, this)) {
+    LargeUIntSub(n, this);
+  }
+  LargeUIntTrim(this);
+}
+
+static void ModSub(const LargeUInt* a, const LargeUInt* n, LargeUInt* this) {
+  if (LargeUIntLessThan(this, a)) {
+    LargeUIntAdd(n, this);
+  }
+  LargeUIntSub(a, this);
+}
+
+static void ModHalve(const LargeUInt* n, LargeUInt* this) {
+  if (this->num_bytes_ > 0 && (this->limbs_[0] & 1)) {
+    LargeUIntAdd(n, this);
+  }
+  int num_limbs = NumLimbs(this);
+  ShiftLimbsDown(this->limbs_, num_limbs, 1, this->limbs_, num_limbs);
+  LargeUIntTrim(this);
+}
+
+// Checks whether n is a perfect square, which the search for D in the Lucas
+// test would never finish on.
+static int IsPerfectSquare(const LargeUInt* n) {
+  LargeUInt root;
+  LargeUInt square;
+  LargeUIntInit(0, &root);
+  LargeUIntInit(0, &square);
+  LargeUIntIsqrt(n, &root);
+  LargeUIntSquare(&root, &square);
+  int is_square = LargeUIntEqual(&square, n);
+  LargeUIntFree(&root);
+  LargeUIntFree(&square);
+  return is_square;
+}
+
+// Sets this to a small signed value modulo n, in Montgomery form.
+static void ToMontSigned(int64_t value, const LargeUIntMontCtx* ctx,
+                         LargeUInt* this) {
+  LargeUIntSetUInt64(value < 0 ? -(uint64_t)value : (uint64_t)value, this);
+  LargeUIntToMont(this, ctx, this);
+  if (value < 0 && this->num_bytes_ > 0) {
+    LargeUInt positive;
+    LargeUIntInit(0, &positive);
+    LargeUIntClone(this, &positive);
+    LargeUIntClone(&ctx->modulus_, this);
+    LargeUIntSub(&positive, this);
+    LargeUIntFree(&positive);
+  }
+}
+
+// The strong Lucas probable prime test with Selfridge's parameters: D is the
+// first of 5, -7, 9, -11, ... with (D / n) = -1, P = 1 and Q = (1 - D) / 4.
+// With n + 1 = d * 2^s, n passes if U(d) is 0 or V(d * 2^r) is 0 for some
+// r < s, all modulo n. The sequences are stepped through the bits of d with
+// the doubling and increment formulas, using Montgomery multiplication. n
+// must be odd and have no factor up to 97.
+static int StrongLucasProbablePrime(const LargeUInt* n) {
+  int64_t d_param = 5;
+  int attempts = 0;
+  while (1) {
+    int jacobi = LargeUIntJacobi(d_param, n);
+    if (jacobi == -1) {
+      break;
+    }
+    if (jacobi == 0) {
+      // D shares a factor with n, which is larger than |D|.
+      return 0;
+    }
+    attempts++;
+    if (attempts == 10 && IsPerfectSquare(n)) {
+      return 0;
+    }
+    d_param = d_param > 0 ? -(d_param + 2) : -d_param + 2;
+  }
+  int64_t q_param = (1 - d_param) / 4;
+
+  // Write n + 1 as d * 2^s.
+  LargeUInt d;
+  LargeUIntInit(0, &d);
+  LargeUIntClone(n, &d);
+  LargeUIntIncrement(&d);
+  int s = 0;
+  while (BitAt(s, &d) == 0) {
+    s++;
+  }
+  ShiftLimbsDown(d.limbs_, NumLimbs(&d), s, d.limbs_, NumLimbs(&d));
+  LargeUIntTrim(&d);
+
+  LargeUIntMontCtx ctx;
+  LargeUIntMontInit(n, &ctx);
+  LargeUInt u, v, q_k, q_mont, d_mont, product;
+  LargeUIntInit(0, &u);
+  LargeUIntInit(0, &v);
+  LargeUIntInit(0, &q_k);
+  LargeUIntInit(0, &q_mont);
+  LargeUIntInit(0, &d_mont);
+  LargeUIntInit(0, &product);
+  ToMontSigned(q_param, &ctx, &q_mont);
+  ToMontSigned(d_param, &ctx, &d_mont);
+
+  // Start at k = 1 with U = 1, V = P = 1 and Q^k = Q.
+  ToMontSigned(1, &ctx, &u);
+  LargeUIntClone(&u, &v);
+  LargeUIntClone(&q_mont, &q_k);
+  int i;
+  for (i = BitLength(&d) - 2; i >= 0; i--) {
+    // U(2k) = U(k) V(k), V(2k) = V(k)^2 - 2 Q^k
+    LargeUIntMontMul(&u, &v, &ctx, &u);
+    LargeUIntMontSqr(&v, &ctx, &v);
+    ModSub(&q_k, n, &v);
+    ModSub(&q_k, n, &v);
+    LargeUIntMontSqr(&q_k, &ctx, &q_k);
+    if (BitAt(i, &d)) {
+      // U(k + 1) = (U(k) + V(k)) / 2, V(k + 1) = (D U(k) + V(k)) / 2
+      LargeUIntMontMul(&d_mont, &u, &ctx, &product);
+      ModAdd(&v, n, &u);
+      ModHalve(n, &u);
+      ModAdd(&product, n, &v);
+      ModHalve(n, &v);
+      LargeUIntMontMul(&q_k, &q_mont, &ctx, &q_k);
+    }
+  }
+
+  int passes = u.num_bytes_ == 0 || v.num_bytes_ == 0;
+  for (i = 1; i < s && !passes; i++) {
+    // V(2k) = V(k)^2 - 2 Q^k
+    LargeUIntMontSqr(&v, &ctx, &v);
+    ModSub(&q_k, n, &v);
+    ModSub(&q_k, n, &v);
+    LargeUIntMontSqr(&q_k, &ctx, &q_k);
+    passes = v.num_bytes_ == 0;
+  }
+
+  LargeUIntMontFree(&ctx);
+  LargeUIntFree(&d);
+  LargeUIntFree(&u);
+  LargeUIntFree(&v);
+  LargeUIntFree(&q_k);
+  LargeUIntFree(&q_mont);
+  LargeUIntFree(&d_mont);
+  LargeUIntFree(&product);
+  return passes;
+}
+
+int LargeUIntIsBailliePSWPrime(const LargeUInt* n) {
+  int small_factors = CheckSmallFactors(n);
+  if (small_factors != -1) {
+    return small_factors;
   }
+  return MillerRabin(n, 1, 1) && StrongLucasProbablePrime(n);
 }
@@ -20,18 +20,43 @@
 #include <stdio.h>
 #include <stdint.h>
 
-#define MAX_NUM_LARGE_U_INT_BYTES 30
-
-// A string buffer to hold a LargeUInt's base 10 represenation could be up to
-// three times the number of bytes with one more byte for the trailing null
-// terminator. This should be a safe overestimate.
-#define BASE_10_LARGE_U_INT_BUFFER_SIZE MAX_NUM_LARGE_U_INT_BYTES * 3 + 1
-
+// The text format records the number of bytes in four hex digits, so this is
+// the largest LargeUInt which can be printed or read back. Values in memory
+// may grow beyond it.
+#define MAX_NUM_LARGE_U_INT_BYTES 0xFFFF
+
+// Values which fit in this many 64 bit limbs are stored inside the LargeUInt
+// itself. Larger values move their limbs to storage taken from a per thread
+// pool which grows as needed.
+#define NUM_LARGE_U_INT_SMALL_LIMBS 4
+
+// The limbs are in little endian order, least significant limb first. The
+// number of bytes is tracked separately so that the byte oriented interface
+// (and leading zero bytes) behave as they always have. Any bytes in the top
+// limb above num_bytes_ are kept at zero.
+//
+// A LargeUInt must be set up with LargeUIntInit before any other use and
+// released with LargeUIntFree when it is no longer needed. Since limbs_ may
+// point into the struct, copy values with LargeUIntClone rather than by
+// assignment.
 typedef struct {
   int num_bytes_;
-  uint8_t bytes_[MAX_NUM_LARGE_U_INT_BYTES];
+  int capacity_;  // The number of limbs available in limbs_.
+  uint64_t* limbs_;
+  uint64_t small_limbs_[NUM_LARGE_U_INT_SMALL_LIMBS];
 } LargeUInt;
 
+// Precomputed values for Montgomery multiplication modulo an odd modulus.
+// With R = 2^(64 * num_limbs_), a value x is kept in Montgomery form as
+// x * R modulo the modulus. Products of values in this form can be reduced
+// with shifts and multiplies instead of division.
+typedef struct {
+  LargeUInt modulus_;
+  LargeUInt r_squared_;  // R^2 modulo the modulus.
+  uint64_t negative_inverse_;  // -1 / modulus modulo 2^64.
+  int num_limbs_;  // The number of limbs in the modulus.
+} LargeUIntMontCtx;
+
 // The human readable format for large ints is in the following form: The
 // number of bytes is listed first in hexidecimal using 2 bytes in little
 // endian order. So for example 0A00 means that the number's value fits in 10
@@ -46,6 +71,10 @@ void LargeUIntPrint(const LargeUInt* this, FILE* out);
 // typically see an integer written.
 void LargeUIntBase10Print(const LargeUInt* this, FILE* out);
 
+// Provides a buffer size which is large enough to hold the base 10 text of
+// this large unsigned integer, including the trailing null terminator.
+int LargeUIntBase10BufferSize(const LargeUInt* this);
+
 // Reads the next available LargeUInt from the file and stores the value in
 // the provided LargeUInt.
 void LargeUIntRead(FILE* in, LargeUInt* this);
@@ -63,13 +92,30 @@ void LargeUIntStore(const LargeUInt* this, int buffer_size, char* buffer);
 void LargeUIntBase10Store(
     const LargeUInt* this, int buffer_size, char* buffer);
 
+// Reads decimal text, high order digits first, from a string and stores the
+// loaded value into the provided location. Leading spaces are skipped and
+// reading stops at the first character which is not a digit.
+void LargeUIntBase10Load(int buffer_size, char* buffer, LargeUInt* this);
+
 // Reads the text representation of a large unsigned integer from a string
 // and stores loaded value into the provided location.
 void LargeUIntLoad(int buffer_size, char* buffer, LargeUInt* this);
 
-// Initializes the large unsigned integer to be ready to store a value.
+// Initializes the large unsigned integer to be ready to store a value. The
+// value starts out as starting_size zero bytes. This must be the first call
+// made on a LargeUInt, and should be matched with a call to LargeUIntFree.
 void LargeUIntInit(int starting_size, LargeUInt* this);
 
+// Releases any storage held by the large unsigned integer back to the pool.
+// The integer is left holding zero and may continue to be used.
+void LargeUIntFree(LargeUInt* this);
+
+// Replaces the value of the large unsigned integer with a 64 bit value.
+void LargeUIntSetUInt64(uint64_t value, LargeUInt* this);
+
+// Provides the low 64 bits of the large unsigned integer's value.
+uint64_t LargeUIntGetUInt64(const LargeUInt* this);
+
 // Increases available size in the large unisigned integer's internal storage.
 void LargeUIntGrow(LargeUInt* this);
 
@@ -145,10 +191,28 @@ void LargeUIntSub(const LargeUInt* that, LargeUInt* this);
 void LargeUIntDecrement(LargeUInt* this);
 
 // Multiplies the second argument by the first, storing the result in the
-// location provided in the second argument. Will cause the program to halt
-// if the result is too big to store in a large unsigned integer.
+// location provided in the second argument.
 void LargeUIntMultiply(const LargeUInt* that, LargeUInt* this);
 
+// Multiplies the first two arguments and stores the result in the third.
+// The product must be a different LargeUInt than either of the factors,
+// which avoids the copy that LargeUIntMultiply needs.
+void LargeUIntProduct(const LargeUInt* a, const LargeUInt* b,
+                      LargeUInt* product);
+
+// Sets the second argument to the square of the first. The two arguments
+// must be different LargeUInts. Squaring takes roughly half the work of a
+// general multiplication.
+void LargeUIntSquare(const LargeUInt* that, LargeUInt* this);
+
+// Sets the operand sizes, in 64 bit limbs, at which multiplication switches
+// from the schoolbook method to Karatsuba, from Karatsuba to Toom-Cook 3 and
+// to number theoretic transforms for the largest values. Values which are
+// too small to work are raised to the smallest usable size. The thresholds
+// are shared by all threads.
+void LargeUIntSetMultiplyThresholds(int karatsuba_limbs, int toom_3_limbs,
+                                    int ntt_limbs);
+
 // Divides the numerator by the denominator storing the results in the
 // quotient and remainder.
 void LargeUIntDivide(const LargeUInt* numerator, const LargeUInt* denominator,
@@ -159,9 +223,80 @@ void LargeUIntDivide(const LargeUInt* numerator, const LargeUInt* denominator,
 void LargeUIntMod(const LargeUInt* numerator, const LargeUInt* divisor,
                   LargeUInt* remainder);
 
-// Finds an integer that is close to the square root of the first argument
-// without being less than the actual square root. Intended for a rough
-// overestimate of the square root.
+// Provides the remainder of the numerator modulo a divisor which fits in a
+// 64 bit word. This is much faster than LargeUIntMod since it makes a single
+// pass over the limbs and never forms a quotient. The divisor must not be 0.
+uint64_t LargeUIntModSmall(const LargeUInt* numerator, uint64_t divisor);
+
+// Finds the integer square root of the first argument, the largest integer
+// whose square does not exceed it. Newton's iteration is started from a power
+// of two just above the root so it settles after a few divisions.
+void LargeUIntIsqrt(const LargeUInt* this, LargeUInt* root);
+
+// Updates root, the integer square root of some earlier value, to be the
+// integer square root of the first argument. The first argument must not be
+// smaller than the earlier value. When it has only grown a little, as when
+// stepping from one prime candidate to the next, this costs a single squaring
+// instead of a full square root.
+void LargeUIntIsqrtUpdate(const LargeUInt* this, LargeUInt* root);
+
+// Finds the square root of the first argument rounded up, so the result is
+// never less than the actual square root. This is the integer square root,
+// plus one when the argument is not a perfect square.
 void LargeUIntApproximateSquareRoot(const LargeUInt* this, LargeUInt* root);
 
+// Prepares a Montgomery context for an odd modulus. Execution will halt if
+// the modulus is even. The context should be released with
+// LargeUIntMontFree.
+void LargeUIntMontInit(const LargeUInt* modulus, LargeUIntMontCtx* ctx);
+
+// Releases the storage held by a Montgomery context.
+void LargeUIntMontFree(LargeUIntMontCtx* ctx);
+
+// Multiplies two values in Montgomery form, storing the product in
+// Montgomery form. Both values must be less than the modulus. The result may
+// be the same LargeUInt as either factor.
+void LargeUIntMontMul(const LargeUInt* a, const LargeUInt* b,
+                      const LargeUIntMontCtx* ctx, LargeUInt* result);
+
+// Squares a value in Montgomery form, storing the square in Montgomery form.
+void LargeUIntMontSqr(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                      LargeUInt* result);
+
+// Converts a value in to Montgomery form. The value is reduced by the
+// modulus first if needed.
+void LargeUIntToMont(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                     LargeUInt* result);
+
+// Converts a value in Montgomery form back to an ordinary value.
+void LargeUIntFromMont(const LargeUInt* a, const LargeUIntMontCtx* ctx,
+                       LargeUInt* result);
+
+// Raises the base to the power of the exponent modulo the modulus, storing
+// the result in the fourth argument. A sliding window over the exponent's
+// bits is used, with the window size picked from the exponent's length. Odd
+// moduli use Montgomery multiplication, and the Montgomery setup and the
+// table of powers are kept between calls so that repeated calls with the
+// same modulus are cheaper. The result may be the same LargeUInt as any of
+// the inputs.
+void LargeUIntPowMod(const LargeUInt* base, const LargeUInt* exponent,
+                     const LargeUInt* modulus, LargeUInt* result);
+
+// Returns 1 if n is probably prime and 0 if it is certainly composite. Small
+// factors are checked first, then the Miller-Rabin strong probable prime test
+// is run. Below 3,317,044,064,679,887,385,961,981 a fixed set of bases is
+// used which makes the answer exact. Above that, rounds bases are tried and a
+// composite passes with probability less than 4^(-rounds).
+int LargeUIntIsProbablePrime(const LargeUInt* n, int rounds);
+
+// Computes the Jacobi symbol (a / n) for a word sized a and an odd n. The
+// result is 1, -1 or 0. Execution will halt if n is even.
+int LargeUIntJacobi(int64_t a, const LargeUInt* n);
+
+// Returns 1 if n passes the Baillie-PSW test and 0 if it is certainly
+// composite. The test is a Miller-Rabin round to base 2 followed by a strong
+// Lucas test with Selfridge's parameters. No composite is known to pass, and
+// none exist below 2^64. It costs about as much as three Miller-Rabin rounds.
+int LargeUIntIsBailliePSWPrime(const LargeUInt* n);
+
 #endif
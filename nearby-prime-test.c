@@ -0,0 +1,172 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nearby-prime.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+int IsPrime(uint64_t n) {
+  uint64_t divisor;
+  for (divisor = 2; divisor * divisor <= n; divisor++) {
+    if (n % divisor == 0) {
+      return 0;
+    }
+  }
+  return n >= 2;
+}
+
+uint64_t NextPrime(uint64_t n) {
+  while (!IsPrime(n)) {
+    n++;
+  }
+  return n;
+}
+
+void TestFindNearbyPrime() {
+  LargeUInt candidate;
+  LargeUIntInit(0, &candidate);
+  uint64_t n;
+  for (n = 0; n < 2000; n++) {
+    LargeUIntSetUInt64(n, &candidate);
+    FindNearbyPrime(&candidate, NULL, NULL);
+    Check(LargeUIntGetUInt64(&candidate) == NextPrime(n),
+          "trial division finds the next prime");
+  }
+  LargeUIntSetUInt64(1000000000000ULL, &candidate);
+  FindNearbyPrime(&candidate, NULL, NULL);
+  Check(LargeUIntGetUInt64(&candidate) == 1000000000039ULL,
+        "the prime after 10^12");
+  LargeUIntFree(&candidate);
+}
+
+void TestFindNearbyProbablePrime() {
+  LargeUInt candidate;
+  LargeUIntInit(0, &candidate);
+  uint64_t n;
+  for (n = 0; n < 2000; n++) {
+    LargeUIntSetUInt64(n, &candidate);
+    FindNearbyProbablePrime(&candidate);
+    Check(LargeUIntGetUInt64(&candidate) == NextPrime(n),
+          "the probable prime test finds the next prime");
+  }
+
+  // A randomly filled candidate can be zero while still holding a byte.
+  LargeUIntFree(&candidate);
+  LargeUIntInit(1, &candidate);
+  LargeUIntSetByte(0, 0, &candidate);
+  FindNearbyProbablePrime(&candidate);
+  Check(LargeUIntGetUInt64(&candidate) == 2, "a zero byte gives 2");
+  LargeUIntFree(&candidate);
+}
+
+void TestDividesEvenly() {
+  LargeUInt divisor;
+  LargeUInt candidate;
+  LargeUInt remainder;
+  LargeUIntInit(0, &divisor);
+  LargeUIntInit(0, &candidate);
+  LargeUIntInit(0, &remainder);
+  LargeUIntSetUInt64(4294967291ULL, &divisor);
+  LargeUIntSetUInt64(4294967291ULL * 3, &candidate);
+  Check(DividesEvenly(&divisor, &candidate, &remainder), "a word divisor");
+  LargeUIntIncrement(&candidate);
+  Check(!DividesEvenly(&divisor, &candidate, &remainder),
+        "a word divisor with a remainder");
+
+  // Divisors past 64 bits take the long division.
+  LargeUIntClone(&divisor, &candidate);
+  LargeUIntMultiply(&candidate, &divisor);
+  LargeUIntClone(&divisor, &candidate);
+  LargeUIntMultiply(&divisor, &candidate);
+  Check(DividesEvenly(&divisor, &candidate, &remainder), "a wide divisor");
+  LargeUIntIncrement(&candidate);
+  Check(!DividesEvenly(&divisor, &candidate, &remainder),
+        "a wide divisor with a remainder");
+  LargeUIntFree(&divisor);
+  LargeUIntFree(&candidate);
+  LargeUIntFree(&remainder);
+}
+
+// Counts the calls FindNearbyPrime makes to its progress function.
+typedef struct {
+  int candidates;
+  int updates;
+  int proved;
+} ProgressCalls;
+
+void CountProgress(const LargeUInt* candidate, const LargeUInt* divisor,
+                   const LargeUInt* max_divisor, void* data) {
+  ProgressCalls* calls = data;
+  if (divisor == NULL) {
+    calls->candidates++;
+  } else if (LargeUIntCompare(divisor, max_divisor) < 0) {
+    calls->proved++;
+  } else {
+    calls->updates++;
+  }
+}
+
+void TestFindNearbyPrimeProgress() {
+  LargeUInt candidate;
+  LargeUIntInit(0, &candidate);
+  // 10^12 + 1 through 10^12 + 38 are all composite, and proving 10^12 + 39
+  // prime takes about 230,000 wheel divisors.
+  LargeUIntSetUInt64(1000000000001ULL, &candidate);
+  ProgressCalls calls = {0, 0, 0};
+  FindNearbyPrime(&candidate, CountProgress, &calls);
+  Check(LargeUIntGetUInt64(&candidate) == 1000000000039ULL,
+        "progress does not change the search");
+  Check(calls.candidates > 1, "each candidate is reported");
+  Check(calls.updates >= 200, "the divisors are reported as they go");
+  Check(calls.proved == 1, "the prime is reported once");
+  LargeUIntFree(&candidate);
+}
+
+// Checks the primes the resumable finder writes, one after the other, when
+// its primes file starts out empty.
+void CheckFirstPrimes(int use_prp, char* message) {
+  LargeUInt prime;
+  LargeUIntInit(0, &prime);
+  uint64_t expected = 2;
+  int i;
+  for (i = 0; i < 200; i++) {
+    FindNextPrime(use_prp, NULL, NULL, &prime);
+    Check(LargeUIntGetUInt64(&prime) == expected, message);
+    expected = NextPrime(expected + 1);
+  }
+  LargeUIntFree(&prime);
+}
+
+void TestFindNextPrime() {
+  CheckFirstPrimes(0, "the first primes by trial division");
+  CheckFirstPrimes(1, "the first primes by the probable prime test");
+}
+
+int main() {
+  TestFindNearbyPrime();
+  TestFindNearbyPrimeProgress();
+  TestFindNearbyProbablePrime();
+  TestDividesEvenly();
+  TestFindNextPrime();
+  printf("All tests passed\n");
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nearby-prime.h"
+#include "wheel.h"
+
+#include <stdio.h>
+
+int DividesEvenly(const LargeUInt* divisor, const LargeUInt* candidate,
+                  LargeUInt* remainder) {
+  if (LargeUIntNumBytes(divisor) <= 8) {
+    return LargeUIntModSmall(candidate, LargeUIntGetUInt64(divisor)) == 0;
+  }
+  LargeUIntMod(candidate, divisor, remainder);
+  return LargeUIntNumBytes(remainder) == 0;
+}
+
+void FindNearbyPrime(LargeUInt* candidate, NearbyPrimeProgress progress,
+                     void* progress_data) {
+  // The wheel skips 2, 3, 5 and 7, so they are handled up front.
+  if (LargeUIntNumBytes(candidate) <= 1 &&
+      WheelSmallPrimeAtLeast(LargeUIntGetUInt64(candidate)) != 0) {
+    LargeUIntSetUInt64(WheelSmallPrimeAtLeast(LargeUIntGetUInt64(candidate)),
+                       candidate);
+    return;
+  }
+
+  // Candidates step through the values with none of 2, 3, 5 or 7 as a
+  // factor.
+  Wheel candidate_wheel;
+  LargeUIntAddByte(
+      WheelInit(LargeUIntModSmall(candidate, WHEEL_MODULUS), &candidate_wheel),
+      candidate);
+
+  LargeUInt remainder;
+  LargeUIntInit(0, &remainder);
+
+  LargeUInt max_divisor;
+  LargeUIntInit(0, &max_divisor);
+  LargeUIntIsqrt(candidate, &max_divisor);
+  if (progress != NULL) {
+    progress(candidate, NULL, &max_divisor, progress_data);
+  }
+  int divisors_to_progress = NEARBY_PRIME_PROGRESS_DIVISORS;
+
+  // The divisors also step through the wheel, since the candidate has no
+  // factor of 2, 3, 5 or 7.
+  LargeUInt divisor;
+  LargeUIntInit(0, &divisor);
+  LargeUIntSetUInt64(11, &divisor);
+  Wheel divisor_wheel;
+  WheelInit(11, &divisor_wheel);
+  while (LargeUIntCompare(&divisor, &max_divisor) >= 0) {
+    if (DividesEvenly(&divisor, candidate, &remainder)) {
+      LargeUIntAddByte(WheelNext(&candidate_wheel), candidate);
+      LargeUIntSetUInt64(11, &divisor);
+      WheelInit(11, &divisor_wheel);
+      // The candidate only grew by a few so the previous cap is nearly right.
+      LargeUIntIsqrtUpdate(candidate, &max_divisor);
+      if (progress != NULL) {
+        progress(candidate, NULL, &max_divisor, progress_data);
+        divisors_to_progress = NEARBY_PRIME_PROGRESS_DIVISORS;
+      }
+    } else {
+      LargeUIntAddByte(WheelNext(&divisor_wheel), &divisor);
+      if (progress != NULL && --divisors_to_progress == 0) {
+        progress(candidate, &divisor, &max_divisor, progress_data);
+        divisors_to_progress = NEARBY_PRIME_PROGRESS_DIVISORS;
+      }
+    }
+  }
+
+  // We ran out of divisors so the value stored in candidate is prime.
+  if (progress != NULL) {
+    progress(candidate, &divisor, &max_divisor, progress_data);
+  }
+  LargeUIntFree(&remainder);
+  LargeUIntFree(&max_divisor);
+  LargeUIntFree(&divisor);
+}
+
+void FindNearbyProbablePrime(LargeUInt* candidate) {
+  // Stepping over even values would skip 2, so it is handled up front.
+  if (LargeUIntNumBytes(candidate) <= 1 &&
+      LargeUIntGetUInt64(candidate) <= 2) {
+    LargeUIntSetUInt64(2, candidate);
+    return;
+  }
+  if ((LargeUIntGetUInt64(candidate) & 1) == 0) {
+    LargeUIntIncrement(candidate);
+  }
+  while (!LargeUIntIsProbablePrime(candidate, PRP_ROUNDS)) {
+    LargeUIntAddByte(2, candidate);
+  }
+}
+
+void FindNextPrime(int use_prp, NearbyPrimeProgress progress,
+                   void* progress_data, LargeUInt* prime) {
+  // Stepping by one rather than two keeps 3 from being skipped after 2. Both
+  // searches move the candidate on to the next value worth testing anyway.
+  LargeUIntIncrement(prime);
+  if (use_prp) {
+    FindNearbyProbablePrime(prime);
+  } else {
+    FindNearbyPrime(prime, progress, progress_data);
+  }
+}
+
+void ProgressBarInit(ProgressBar* this) {
+  this->candidates_ = 0;
+  this->marks_ = 0;
+  LargeUIntInit(0, &this->one_fiftieth_);
+  LargeUIntInit(0, &this->next_mark_);
+}
+
+void ProgressBarFree(ProgressBar* this) {
+  LargeUIntFree(&this->one_fiftieth_);
+  LargeUIntFree(&this->next_mark_);
+}
+
+void ProgressBarShow(const LargeUInt* candidate, const LargeUInt* divisor,
+                     const LargeUInt* max_divisor, void* data) {
+  ProgressBar* this = data;
+  if (divisor == NULL) {
+    printf(this->candidates_ == 0 ? "Starting with possible prime "
+                                  : "\nTrying a new possible prime ");
+    LargeUIntBase10Print(candidate, stdout);
+    printf("\nMaximum divisor: ");
+    LargeUIntPrint(max_divisor, stdout);
+    printf("\nProgress: 0|-------20|-------40|-------60|-------80|------100|");
+    printf("\n           x");
+    fflush(stdout);
+    this->candidates_++;
+    this->marks_ = 1;
+
+    // Mark each fiftieth of the divisors as it is passed.
+    LargeUInt fifty;
+    LargeUInt remainder;
+    LargeUIntInit(0, &fifty);
+    LargeUIntInit(0, &remainder);
+    LargeUIntSetUInt64(50, &fifty);
+    LargeUIntDivide(max_divisor, &fifty, &this->one_fiftieth_, &remainder);
+    LargeUIntClone(&this->one_fiftieth_, &this->next_mark_);
+    LargeUIntFree(&fifty);
+    LargeUIntFree(&remainder);
+    return;
+  }
+  while (this->marks_ < 50 &&
+         LargeUIntCompare(divisor, &this->next_mark_) < 1) {
+    printf("x");
+    this->marks_++;
+    LargeUIntAdd(&this->one_fiftieth_, &this->next_mark_);
+  }
+  fflush(stdout);
+}
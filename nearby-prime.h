@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NEARBY_PRIME_H
+#define NEARBY_PRIME_H
+
+#include "large-u-int.h"
+
+// The number of Miller-Rabin rounds used in --prp mode.
+#define PRP_ROUNDS 25
+
+// Checks whether the divisor divides the candidate evenly. Divisors which
+// fit in a 64 bit word use the single pass remainder. remainder is used as
+// scratch space for larger divisors.
+int DividesEvenly(const LargeUInt* divisor, const LargeUInt* candidate,
+                  LargeUInt* remainder);
+
+// How many divisors FindNearbyPrime tries between calls to its progress
+// function.
+#define NEARBY_PRIME_PROGRESS_DIVISORS 1024
+
+// Follows a trial division search, which can take a long time for a large
+// candidate. It is called with a NULL divisor each time a new candidate is
+// started, then every NEARBY_PRIME_PROGRESS_DIVISORS divisors with the
+// divisor reached, and once the candidate is proved prime with a divisor
+// past max_divisor. data is whatever the caller passed to the search.
+typedef void (*NearbyPrimeProgress)(const LargeUInt* candidate,
+                                    const LargeUInt* divisor,
+                                    const LargeUInt* max_divisor, void* data);
+
+// Moves the candidate up to the smallest prime which is at least as large,
+// proving it prime by trial division. progress may be NULL.
+void FindNearbyPrime(LargeUInt* candidate, NearbyPrimeProgress progress,
+                     void* progress_data);
+
+// Moves the candidate up to the smallest value which is at least as large and
+// passes the probable prime test with PRP_ROUNDS rounds. This is far faster
+// than trial division for large candidates.
+void FindNearbyProbablePrime(LargeUInt* candidate);
+
+// Moves prime on to the smallest prime, or probable prime with use_prp set,
+// which is above it. Starting from 0 this gives 2, 3, 5 and so on. progress
+// is passed on to the trial division search and may be NULL.
+void FindNextPrime(int use_prp, NearbyPrimeProgress progress,
+                   void* progress_data, LargeUInt* prime);
+
+// Draws a bar on stdout for each candidate, which fills in as each fiftieth of
+// its divisors is tried.
+//
+// A ProgressBar must be set up with ProgressBarInit and released with
+// ProgressBarFree.
+typedef struct {
+  int candidates_;  // How many candidates have been started.
+  int marks_;  // How many fiftieths of the divisors have been marked.
+  LargeUInt one_fiftieth_;
+  LargeUInt next_mark_;
+} ProgressBar;
+
+void ProgressBarInit(ProgressBar* this);
+
+void ProgressBarFree(ProgressBar* this);
+
+// A NearbyPrimeProgress which draws the ProgressBar passed as data.
+void ProgressBarShow(const LargeUInt* candidate, const LargeUInt* divisor,
+                     const LargeUInt* max_divisor, void* data);
+
+#endif
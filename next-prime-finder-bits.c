@@ -15,92 +15,172 @@
  */
 
 #include "bit-u-int.h"
+#include "wheel.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 
-void FindNearbyPrime(BitUInt* candidate) {
-  // If the starting point is even, make it odd.
-  candidate->bits[0] = 1;
+// Trial divisors are taken from a table of the odd primes up to this limit.
+// Beyond it every number with none of 2, 3, 5 or 7 as a factor is tried.
+#define PRIME_TABLE_LIMIT 1000000
+#define MAX_TABLE_PRIMES 80000
+
+// The remainders of the candidate modulo this many of the smallest primes are
+// kept up to date as the candidate steps by two, so candidates with a small
+// factor are skipped without any division.
+#define NUM_RESIDUE_PRIMES 64
+
+uint32_t prime_table[MAX_TABLE_PRIMES];
+int num_table_primes;
+
+// Fills prime_table with the odd primes up to PRIME_TABLE_LIMIT using the
+// sieve of Eratosthenes.
+void BuildPrimeTable() {
+  char* is_composite = calloc(PRIME_TABLE_LIMIT + 1, 1);
+  if (is_composite == NULL) {
+    printf("Unable to allocate the prime table sieve.\n");
+    exit(1);
+  }
+  uint32_t i, j;
+  num_table_primes = 0;
+  for (i = 3; i <= PRIME_TABLE_LIMIT; i += 2) {
+    if (is_composite[i]) {
+      continue;
+    }
+    prime_table[num_table_primes] = i;
+    num_table_primes++;
+    if (i > PRIME_TABLE_LIMIT / i) {
+      continue;
+    }
+    for (j = i * i; j <= PRIME_TABLE_LIMIT; j += 2 * i) {
+      is_composite[j] = 1;
+    }
+  }
+  free(is_composite);
+}
 
-  BitUInt quotient;
-  BitUInt remainder;
+// Reports whether one of the residue primes divides the candidate, other than
+// the candidate being that prime itself.
+int HasSmallFactor(const BitUInt* candidate, const uint32_t* residues) {
+  int i;
+  for (i = 0; i < NUM_RESIDUE_PRIMES; i++) {
+    if (residues[i] == 0) {
+      return candidate->num_bits > 32 ||
+             BitUIntGetUInt64(candidate) != prime_table[i];
+    }
+  }
+  return 0;
+}
 
-  // Establish the limit of the highest divisor we need to try.
-  BitUInt max_divisor;
-  //LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-  BitUIntClone(candidate, &max_divisor);
-  BitUIntHalve(&max_divisor);
+// Moves to the next odd candidate, keeping the residues in step.
+void NextCandidate(BitUInt* candidate, uint32_t* residues) {
+  BitUIntInc(candidate);
+  BitUIntInc(candidate);
+  int i;
+  for (i = 0; i < NUM_RESIDUE_PRIMES; i++) {
+    residues[i] += 2;
+    if (residues[i] >= prime_table[i]) {
+      residues[i] -= prime_table[i];
+    }
+  }
+}
+
+// Tries each divisor up to max_divisor, first the primes in the table and
+// then the values on the wheel beyond it. Returns 1 if a divisor is found.
+int HasDivisor(const BitUInt* candidate, const BitUInt* max_divisor) {
+  BitUInt remainder;
+  BitUInt divisor;
+  BitUInt step;
+  Wheel wheel;
 
   // To report progress, track when we have tried each 2% of the possible
   // divisors.
   BitUInt one_fiftieth_max;
   BitUInt next_reporting_milestone;
   BitUInt fifty;
-  fifty.num_bits = 6;
-  fifty.bits[0] = 0;
-  fifty.bits[1] = 1;
-  fifty.bits[2] = 0;
-  fifty.bits[3] = 0;
-  fifty.bits[4] = 1;
-  fifty.bits[5] = 1;
-  BitUIntDiv(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
+  BitUIntSetUInt64(50, &fifty);
+  BitUIntDiv(max_divisor, &fifty, &one_fiftieth_max, &remainder);
   BitUIntClone(&one_fiftieth_max, &next_reporting_milestone);
 
+  // The residue primes have already been ruled out.
+  int table_index = NUM_RESIDUE_PRIMES;
+  BitUIntSetUInt64(prime_table[table_index], &divisor);
+  while (BitUIntCompare(&divisor, max_divisor) >= 0) {
+    BitUIntMod(candidate, &divisor, &remainder);
+    if (remainder.num_bits == 0) {
+      return 1;
+    }
+
+    // Once the table runs out, table_index stays at num_table_primes so it
+    // cannot overflow however long the wheel runs.
+    if (table_index + 1 < num_table_primes) {
+      table_index++;
+      BitUIntSetUInt64(prime_table[table_index], &divisor);
+    } else {
+      if (table_index + 1 == num_table_primes) {
+        // The divisor is the last prime in the table, which is on the wheel.
+        table_index++;
+        WheelInit(prime_table[num_table_primes - 1] % WHEEL_MODULUS, &wheel);
+      }
+      BitUIntSetUInt64(WheelNext(&wheel), &step);
+      BitUIntAdd(&step, &divisor);
+    }
+    if (BitUIntCompare(&divisor, &next_reporting_milestone) < 1) {
+      printf("x");
+      fflush(stdout);
+      BitUIntAdd(&one_fiftieth_max, &next_reporting_milestone);
+    }
+  }
+  return 0;
+}
+
+void FindNearbyPrime(BitUInt* candidate) {
+  // If the starting point is even, make it odd.
+  if (BitUIntGetBit(0, candidate) == 0) {
+    BitUIntInc(candidate);
+  }
+
   printf("Starting with possible prime ");
   BitUIntBase10Print(candidate);
-  printf("\nMaximum divisor: ");
-  BitUIntPrint(&max_divisor);
-  printf("\nProgress: 0|-------20|-------40|-------60|-------80|------100|");
-  printf("\n           x");
   fflush(stdout);
 
-  // Try divisors starting with the smallest possible: 3.
+  uint32_t residues[NUM_RESIDUE_PRIMES];
   BitUInt divisor;
-  divisor.num_bits = 2;
-  divisor.bits[0] = 1;
-  divisor.bits[1] = 1;
-  while (BitUIntCompare(&divisor, &max_divisor) >= 0) {
+  BitUInt remainder;
+  int i;
+  for (i = 0; i < NUM_RESIDUE_PRIMES; i++) {
+    BitUIntSetUInt64(prime_table[i], &divisor);
     BitUIntMod(candidate, &divisor, &remainder);
-    if (remainder.num_bits == 0) {
-      // Add two to the candidate to see if the next odd number is prime.
-      BitUIntInc(candidate);
-      BitUIntInc(candidate);
-      // Start over with the lowest possible divisor (3).
-      divisor.num_bits = 2;
-      divisor.bits[0] = 1;
-      divisor.bits[1] = 1;
-
-      printf("\nTrying a new possible prime ");
-      BitUIntBase10Print(candidate);
-      printf("\nMaximum divisor: ");
-      BitUIntPrint(&max_divisor);
-      printf("\nProgress: 0|-------20|-------40|-------60|-------80|");
-      printf("------100|\n           x");
-      fflush(stdout);
+    residues[i] = BitUIntGetUInt64(&remainder);
+  }
 
-      // New candidate so find a new cap for divisors.
-      //LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-      BitUIntClone(candidate, &max_divisor);
-      BitUIntHalve(&max_divisor);
+  // Establish the limit of the highest divisor we need to try. As the
+  // candidate steps up by two the limit only needs an occasional bump.
+  BitUInt max_divisor;
+  BitUIntIsqrt(candidate, &max_divisor);
 
-      // Report the new candidate and reset our progress reporting.
-      BitUIntDiv(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
-      BitUIntClone(&one_fiftieth_max, &next_reporting_milestone);
-    } else {
-      BitUIntInc(&divisor);
-      BitUIntInc(&divisor);
-      if (BitUIntCompare(&divisor, &next_reporting_milestone) < 1) {
-        printf("x");
-        fflush(stdout);
-        BitUIntAdd(&one_fiftieth_max, &next_reporting_milestone);
-      }
+  while (1) {
+    while (HasSmallFactor(candidate, residues)) {
+      NextCandidate(candidate, residues);
     }
+    BitUIntIsqrtUpdate(candidate, &max_divisor);
+
+    printf("\nTrying possible prime ");
+    BitUIntBase10Print(candidate);
+    printf("\nMaximum divisor: ");
+    BitUIntPrint(&max_divisor);
+    printf("\nProgress: 0|-------20|-------40|-------60|-------80|");
+    printf("------100|\n           x");
+    fflush(stdout);
+
+    if (!HasDivisor(candidate, &max_divisor)) {
+      // We ran out of divisors so the value stored in candidate is prime.
+      return;
+    }
+    NextCandidate(candidate, residues);
   }
-
-  // We ran out of divisors so the value stored in candidate is prime.
 }
 
 void PrintPrime(BitUInt* prime) {
@@ -119,6 +199,7 @@ int main(int argc, char *argv[]) {
   }
   BitUInt prime;
   BitUIntLoad(strlen(argv[1]), argv[1], &prime);
+  BuildPrimeTable();
   FindNearbyPrime(&prime);
   printf("\nPrime:\n");
   PrintPrime(&prime);
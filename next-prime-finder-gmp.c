@@ -1,24 +1,35 @@
+#include "wheel.h"
+
 #include <stdio.h>
 #include <gmp.h>
 
 void FindNearbyPrime(mpz_t candidate) {
+  // The wheel skips 2, 3, 5 and 7, so they are handled up front.
+  if (mpz_cmp_ui(candidate, 7) <= 0) {
+    mpz_set_ui(candidate, WheelSmallPrimeAtLeast(mpz_get_ui(candidate)));
+    return;
+  }
+
   mpz_t divisor;
   mpz_t limit;
   mpz_init(divisor);
   mpz_init(limit);
-  mpz_set_ui(divisor, 2);
   mpz_t remainder;
   mpz_init(remainder);
 
-  mpz_mod(remainder, candidate, divisor);
-  if (mpz_size(remainder) == 0) {
-    mpz_add_ui(candidate, candidate, 1);
-  }
-  
-  // The candidate should now be odd.
+  // Candidates step through the values with none of 2, 3, 5 or 7 as a
+  // factor.
+  Wheel candidate_wheel;
+  mpz_add_ui(candidate, candidate,
+             WheelInit(mpz_fdiv_ui(candidate, WHEEL_MODULUS),
+                       &candidate_wheel));
   printf("Starting with possible prime %s\n", mpz_get_str(NULL, 10, candidate));
 
-  mpz_set_ui(divisor, 3);
+  // The divisors also step through the wheel, starting from 11, since the
+  // candidate has no factor of 2, 3, 5 or 7.
+  Wheel divisor_wheel;
+  mpz_set_ui(divisor, 11);
+  WheelInit(11, &divisor_wheel);
   mpz_root(limit, candidate, 2);
   // Round up the square root (may not really be necessary).
   mpz_add_ui(limit, limit, 1);
@@ -27,19 +38,23 @@ void FindNearbyPrime(mpz_t candidate) {
     if (mpz_size(remainder) == 0) {
       printf("%s is not prime (divisible by %s)\n",
              mpz_get_str(NULL, 10, candidate), mpz_get_str(NULL, 10, divisor));
-      // Incremend the candidate by 2.
-      mpz_add_ui(candidate, candidate, 2);
-      // Start over with a divisor of 3.
-      mpz_set_ui(divisor, 3);
+      // Move the candidate on to the next value on the wheel.
+      mpz_add_ui(candidate, candidate, WheelNext(&candidate_wheel));
+      // Start over with a divisor of 11.
+      mpz_set_ui(divisor, 11);
+      WheelInit(11, &divisor_wheel);
       mpz_root(limit, candidate, 2);
       mpz_add_ui(limit, limit, 1);
     } else {
-      // Try the next higher divisor (step by 2).
-      mpz_add_ui(divisor, divisor, 2);
+      // Try the next higher divisor on the wheel.
+      mpz_add_ui(divisor, divisor, WheelNext(&divisor_wheel));
     }
   }
 
   // We ran out of divisors so the value stored in candidate is prime.
+  mpz_clear(divisor);
+  mpz_clear(limit);
+  mpz_clear(remainder);
 }
 
 int main(int argc, char *argv[]) {
@@ -15,80 +15,13 @@
  */
 
 #include "large-u-int.h"
+#include "nearby-prime.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 
-void FindNearbyPrime(LargeUInt* candidate) {
-  if (LargeUIntGetByte(0, candidate) % 2 == 0) {
-    LargeUIntIncrement(candidate);
-  }
-
-  LargeUInt quotient;
-  LargeUInt remainder;
-
-  // Establish the limit of the highest divisor we need to try.
-  LargeUInt max_divisor;
-  LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-
-  // To report progress, track when we have tried each 2% of the possible
-  // divisors.
-  LargeUInt one_fiftieth_max;
-  LargeUInt next_reporting_milestone;
-  LargeUInt fifty;
-  LargeUIntInit(1, &fifty);
-  LargeUIntSetByte(50, 0, &fifty);
-  LargeUIntDivide(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
-  LargeUIntClone(&one_fiftieth_max, &next_reporting_milestone);
-
-  printf("Starting with possible prime ");
-  LargeUIntBase10Print(candidate, stdout);
-  printf("\nMaximum divisor: ");
-  LargeUIntPrint(&max_divisor, stdout);
-  printf("\nProgress: 0|-------20|-------40|-------60|-------80|------100|");
-  printf("\n           x");
-  fflush(stdout);
-
-  // Try divisors starting with the smallest possible: 3.
-  LargeUInt divisor;
-  LargeUIntInit(1, &divisor);
-  LargeUIntSetByte(3, 0, &divisor);
-  while (LargeUIntCompare(&divisor, &max_divisor) >= 0) {
-    LargeUIntMod(candidate, &divisor, &remainder);
-    if (LargeUIntNumBytes(&remainder) == 0) {
-      LargeUIntAddByte(2, candidate);
-      LargeUIntInit(1, &divisor);
-      LargeUIntSetByte(3, 0, &divisor);
-
-      printf("\nTrying a new possible prime ");
-      LargeUIntBase10Print(candidate, stdout);
-      printf("\nMaximum divisor: ");
-      LargeUIntPrint(&max_divisor, stdout);
-      printf("\nProgress: 0|-------20|-------40|-------60|-------80|");
-      printf("------100|\n           x");
-      fflush(stdout);
-
-      // New candidate so find a new cap for divisors.
-      LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-
-      // Report the new candidate and reset our progress reporting.
-      LargeUIntDivide(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
-      LargeUIntClone(&one_fiftieth_max, &next_reporting_milestone);
-    } else {
-      LargeUIntAddByte(2, &divisor);
-      if (LargeUIntCompare(&divisor, &next_reporting_milestone) < 1) {
-        printf("x");
-        fflush(stdout);
-        LargeUIntAdd(&one_fiftieth_max, &next_reporting_milestone);
-      }
-    }
-  }
-
-  // We ran out of divisors so the value stored in candidate is prime.
-}
-
 void PrintPrime(LargeUInt* prime, FILE* out) {
   LargeUIntPrint(prime, out);
   fprintf(out, " # int value: ");
@@ -97,18 +30,41 @@ void PrintPrime(LargeUInt* prime, FILE* out) {
 }
 
 int main(int argc, char *argv[]) {
+  int use_prp = 0;
+  if (argc > 1 && strcmp(argv[1], "--prp") == 0) {
+    use_prp = 1;
+    argc--;
+    argv++;
+  }
   if (argc < 2) {
-    printf("Usage: %s <starting number in LargeUInt format>\n", argv[0]);
-    printf("For example %s 0100_0D\n", argv[0]);
+    printf("Usage: %s [--prp] <starting number>\n", argv[0]);
+    printf("The starting number is in LargeUInt format or decimal.\n");
+    printf("For example %s 0100_0D or %s 13\n", argv[0], argv[0]);
+    printf("With --prp the Miller-Rabin test is used instead of trial "
+           "division.\n");
     return 1;
   }
   LargeUInt prime;
-  LargeUIntLoad(strlen(argv[1]), argv[1], &prime);
-  FindNearbyPrime(&prime);
-  printf("\nPrime:\n");
+  LargeUIntInit(0, &prime);
+  // The LargeUInt format always has an underscore after the byte count.
+  if (strchr(argv[1], '_') != NULL) {
+    LargeUIntLoad(strlen(argv[1]), argv[1], &prime);
+  } else {
+    LargeUIntBase10Load(strlen(argv[1]), argv[1], &prime);
+  }
+  if (use_prp) {
+    FindNearbyProbablePrime(&prime);
+    printf("\nProbable prime:\n");
+  } else {
+    ProgressBar progress_bar;
+    ProgressBarInit(&progress_bar);
+    FindNearbyPrime(&prime, ProgressBarShow, &progress_bar);
+    ProgressBarFree(&progress_bar);
+    printf("\nPrime:\n");
+  }
   PrintPrime(&prime, stdout);
   printf("\n");
+  LargeUIntFree(&prime);
 
   return 0;
 }
-
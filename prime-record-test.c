@@ -0,0 +1,99 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "large-u-int.h"
+#include "prime-record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+// Checks that the record for x reads back as x, and that its hex part is
+// what LargeUIntPrint gives for the same value.
+void CheckRoundTrip(unsigned __int128 x, char* message) {
+  char record[PRIME_RECORD_BYTES];
+  int length = FormatPrime(x, record);
+  Check(length == (int)strlen(record) && record[length - 1] == '\n', message);
+
+  FILE* file = tmpfile();
+  Check(file != NULL, "a temporary file can be created");
+  fputs(record, file);
+  fputs(record, file);
+  rewind(file);
+  Check(LoadNextPrime(file) == x, message);
+  Check(LoadNextPrime(file) == x, message);
+  fclose(file);
+
+  LargeUInt value;
+  LargeUIntInit(0, &value);
+  int num_bytes = 0;
+  while (num_bytes < 16 && x >> (8 * num_bytes) != 0) {
+    num_bytes++;
+  }
+  if (num_bytes > 0) {
+    LargeUIntFree(&value);
+    LargeUIntInit(num_bytes, &value);
+  }
+  int i;
+  for (i = 0; i < num_bytes; i++) {
+    LargeUIntSetByte((int)(x >> (8 * i) & 0xFF), i, &value);
+  }
+  file = tmpfile();
+  Check(file != NULL, "a temporary file can be created");
+  LargeUIntPrint(&value, file);
+  fputs(" #", file);
+  rewind(file);
+  char printed[PRIME_RECORD_BYTES];
+  Check(fgets(printed, sizeof(printed), file) != NULL, message);
+  fclose(file);
+  Check(strncmp(record, printed, strlen(printed)) == 0, message);
+  LargeUIntFree(&value);
+}
+
+void TestRoundTrip() {
+  unsigned __int128 two_64 = (unsigned __int128)1 << 64;
+  CheckRoundTrip(0, "zero");
+  CheckRoundTrip(2, "two");
+  CheckRoundTrip(255, "one full byte");
+  CheckRoundTrip(256, "two bytes");
+  CheckRoundTrip(two_64 - 1, "2^64 - 1");
+  CheckRoundTrip(two_64, "2^64");
+  CheckRoundTrip(~(unsigned __int128)0, "2^128 - 1");
+}
+
+void TestFormat() {
+  char record[PRIME_RECORD_BYTES];
+  FormatPrime(13, record);
+  Check(strcmp(record, "0100_0D # int value: 13\n") == 0, "the record for 13");
+  FormatPrime(0, record);
+  Check(strcmp(record, "0000_ # int value: 0\n") == 0, "the record for 0");
+  FormatPrime(~(unsigned __int128)0, record);
+  Check(strcmp(record, "1000_FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF # int value: "
+                       "340282366920938463463374607431768211455\n") == 0,
+        "the record for 2^128 - 1");
+}
+
+int main() {
+  TestRoundTrip();
+  TestFormat();
+  printf("All tests passed\n");
+}
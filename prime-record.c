@@ -0,0 +1,173 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "prime-record.h"
+
+#include <stdlib.h>
+
+static const char HEX_BYTES[] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                 '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+int FormatBase10(unsigned __int128 x, char* digits) {
+  char reversed[40];
+  int length = 0;
+  do {
+    reversed[length++] = '0' + (int)(x % 10);
+    x /= 10;
+  } while (x > 0);
+  int i;
+  for (i = 0; i < length; i++) {
+    digits[i] = reversed[length - 1 - i];
+  }
+  digits[length] = '\0';
+  return length;
+}
+
+int FormatPrime(unsigned __int128 x, char* record) {
+  // Zero has no bytes, as in LargeUIntPrint.
+  int num_bytes = 0;
+  while (num_bytes < 16 && x >> (8 * num_bytes) != 0) {
+    num_bytes++;
+  }
+
+  int length = sprintf(record, "%c%c00_", HEX_BYTES[num_bytes >> 4],
+                       HEX_BYTES[num_bytes & 0x0F]);
+  unsigned __int128 x_copy = x;
+  while (x > 0) {
+    record[length++] = HEX_BYTES[x >> 4 & 0x0F];
+    record[length++] = HEX_BYTES[x & 0x0F];
+    x >>= 8;
+  }
+  length += sprintf(&record[length], " # int value: ");
+  length += FormatBase10(x_copy, &record[length]);
+  record[length++] = '\n';
+  record[length] = '\0';
+  return length;
+}
+
+static int HexCharToNibble(char hex_char) {
+  if (hex_char >= '0' && hex_char <= '9') {
+    return hex_char - '0';
+  } else if (hex_char >= 'A' && hex_char <= 'F') {
+    return hex_char + 10 - 'A';
+  } else {
+    return -1;
+  }
+}
+
+unsigned __int128 LoadNextPrime(FILE* primes) {
+  if (primes == NULL) {
+    return 0;
+  }
+
+  int current = fgetc(primes);
+  int state = 0;
+  int num_bytes = 0;
+  int byte_index = 0;
+  int current_value = -1;
+  unsigned __int128 result = 0;
+  int shift = 0;
+  while (1) {
+    if (feof(primes)) {
+      break;
+    }
+
+    if (current == '#') {
+      state = 10;
+    }
+
+    if (state == 10) {
+      if (current == '\n') {
+        state = 0;
+      }
+      current = fgetc(primes);
+      continue;
+    }
+
+    current_value = HexCharToNibble(current);
+    if (current_value == -1) {
+      // Skip over non hex characters.
+      current = fgetc(primes);
+      continue;
+    }
+
+    switch (state) {
+      // First char of 8 in the num_bytes.
+      case 0:
+        num_bytes = current_value << 4;
+        state = 1;
+        break;
+      case 1:
+        num_bytes += current_value;
+        state = 2;
+        break;
+      case 2:
+        num_bytes += current_value << 12;
+        state = 3;
+        break;
+      case 3:
+        num_bytes += current_value << 8;
+        if (num_bytes == 0) {
+          // Zero has no byte digits to read.
+          return 0;
+        }
+        if (num_bytes > 16) {
+          fprintf(stderr, "The primes file has passed 2^128, so "
+                  "large-u-int-resumable-prime-finder takes over from "
+                  "here.\n");
+          exit(1);
+        }
+        state = 8;
+        break;
+      case 4:
+        num_bytes += current_value << 20;
+        state = 5;
+        break;
+      case 5:
+        num_bytes += current_value << 16;
+        state = 6;
+        break;
+      case 6:
+        num_bytes += current_value << 28;
+        state = 7;
+        break;
+      case 7:
+        num_bytes += current_value << 24;
+        state = 8;  // Reached the end of num_bytes;
+        result = 0;
+        byte_index = 0;
+        break;
+      case 8:
+        result += (unsigned __int128)(current_value << 4) << shift;
+        state = 9;
+        break;
+      case 9:
+        result += (unsigned __int128)current_value << shift;
+        byte_index++;
+        shift += 8;
+        if (byte_index < num_bytes) {
+          state = 8;
+        } else {
+          return result;
+        }
+        break;
+      case 10:
+        break;
+    }
+    current = fgetc(primes);
+  }
+  return 0;
+}
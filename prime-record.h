@@ -0,0 +1,42 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRIME_RECORD_H
+#define PRIME_RECORD_H
+
+#include <stdio.h>
+
+// Reads and writes the records of the primes file for values below 2^128, in
+// the format LargeUIntPrint uses followed by the base 10 value as a comment.
+// For example 13 is "0100_0D # int value: 13".
+
+// The most bytes FormatPrime writes: the byte count, 32 hex digits, the
+// comment, up to 39 decimal digits, the newline and a null terminator.
+#define PRIME_RECORD_BYTES 96
+
+// Writes x in base 10 into digits, which must have room for 40 bytes, and
+// returns its length. printf cannot do this past 64 bits.
+int FormatBase10(unsigned __int128 x, char* digits);
+
+// Writes the primes file record for x into record, which must have room for
+// PRIME_RECORD_BYTES, and returns its length.
+int FormatPrime(unsigned __int128 x, char* record);
+
+// Reads the next record from the primes file, skipping comments. Returns 0
+// at the end of the file. Execution halts if the record is past 2^128.
+unsigned __int128 LoadNextPrime(FILE* primes);
+
+#endif
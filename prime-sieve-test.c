@@ -0,0 +1,289 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "prime-sieve.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// The tests which depend on where segments start use the fixed sizes.
+PrimeSieveSizes default_sizes = {PRIME_SIEVE_SEGMENT_BYTES,
+                                 PRIME_SIEVE_BUCKET_BYTES};
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+int IsPrimeByTrialDivision(uint64_t n) {
+  if (n < 2) {
+    return 0;
+  }
+  if (n % 2 == 0) {
+    return n == 2;
+  }
+  uint64_t divisor;
+  for (divisor = 3; divisor <= n / divisor; divisor += 2) {
+    if (n % divisor == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+uint64_t MultiplyMod(uint64_t a, uint64_t b, uint64_t n) {
+  return (unsigned __int128)a * b % n;
+}
+
+// Miller-Rabin with the first twelve primes as bases, which is exact for
+// every 64 bit value. Trial division is too slow to check windows this high.
+int IsPrimeByMillerRabin(uint64_t n) {
+  uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+  int num_bases = sizeof(bases) / sizeof(bases[0]);
+  int i;
+  for (i = 0; i < num_bases; i++) {
+    if (n % bases[i] == 0) {
+      return n == bases[i];
+    }
+  }
+  if (n < 2) {
+    return 0;
+  }
+
+  uint64_t d = n - 1;
+  int s = 0;
+  while (d % 2 == 0) {
+    d /= 2;
+    s++;
+  }
+  for (i = 0; i < num_bases; i++) {
+    uint64_t x = 1;
+    uint64_t base = bases[i];
+    uint64_t e;
+    for (e = d; e > 0; e /= 2) {
+      if (e % 2 == 1) {
+        x = MultiplyMod(x, base, n);
+      }
+      base = MultiplyMod(base, base, n);
+    }
+    if (x == 1 || x == n - 1) {
+      continue;
+    }
+    int r;
+    for (r = 1; r < s && x != n - 1; r++) {
+      x = MultiplyMod(x, x, n);
+    }
+    if (x != n - 1) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void TestFirstPrimes() {
+  uint64_t expected[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+  PrimeSieve sieve;
+  PrimeSieveInit(0, &default_sizes, &sieve);
+  int i;
+  for (i = 0; i < (int)(sizeof(expected) / sizeof(expected[0])); i++) {
+    Check(PrimeSieveNext(&sieve) == expected[i], "first primes from 0");
+  }
+  PrimeSieveFree(&sieve);
+
+  PrimeSieveInit(13, &default_sizes, &sieve);
+  Check(PrimeSieveNext(&sieve) == 13, "a prime start is reported");
+  Check(PrimeSieveNext(&sieve) == 17, "17 follows 13");
+  PrimeSieveFree(&sieve);
+
+  PrimeSieveInit(14, &default_sizes, &sieve);
+  Check(PrimeSieveNext(&sieve) == 17, "even start moves to 17");
+  PrimeSieveFree(&sieve);
+
+  PrimeSieveInit(3, &default_sizes, &sieve);
+  Check(PrimeSieveNext(&sieve) == 3, "start of 3 skips 2");
+  PrimeSieveFree(&sieve);
+
+  // The pattern crosses off 3, 5, 7, 11 and 13 along with their multiples.
+  PrimeSieveInit(9, &default_sizes, &sieve);
+  Check(PrimeSieveNext(&sieve) == 11, "11 follows 9");
+  Check(PrimeSieveNext(&sieve) == 13, "13 follows 11");
+  PrimeSieveFree(&sieve);
+}
+
+void TestPrimeCount() {
+  PrimeSieve sieve;
+  PrimeSieveInit(1, &default_sizes, &sieve);
+  int count = 0;
+  uint64_t previous = 0;
+  uint64_t prime = PrimeSieveNext(&sieve);
+  while (prime < 10000000) {
+    Check(prime > previous, "primes are in increasing order");
+    previous = prime;
+    count++;
+    prime = PrimeSieveNext(&sieve);
+  }
+  Check(count == 664579, "there are 664579 primes below 10^7");
+  PrimeSieveFree(&sieve);
+}
+
+// Compares the primes the sieve reports between window_start and window_end
+// with the is_prime test. The sieve itself starts from start, so a window
+// past the first segment checks that sieving carries over between segments.
+void CheckWindow(uint64_t start, uint64_t window_start, uint64_t window_end,
+                 int (*is_prime)(uint64_t), char* message) {
+  PrimeSieve sieve;
+  PrimeSieveInit(start, &default_sizes, &sieve);
+  uint64_t prime = PrimeSieveNext(&sieve);
+  while (prime < window_start) {
+    prime = PrimeSieveNext(&sieve);
+  }
+  uint64_t n;
+  for (n = window_start; n <= window_end; n++) {
+    if (is_prime(n)) {
+      Check(prime == n, message);
+      prime = PrimeSieveNext(&sieve);
+    }
+  }
+  Check(prime > window_end, message);
+  PrimeSieveFree(&sieve);
+}
+
+void TestLargeStarts() {
+  uint64_t start = 1000000000000ull;
+  uint64_t boundary = start + 1 + 16 * PRIME_SIEVE_SEGMENT_BYTES;
+  CheckWindow(start, start, start + 10000, IsPrimeByTrialDivision,
+              "primes after 10^12");
+  CheckWindow(start, boundary - 10000, boundary + 10000,
+              IsPrimeByTrialDivision, "primes across a segment boundary");
+
+  start = ((uint64_t)1 << 40) - 5000;
+  CheckWindow(start, start, start + 10000, IsPrimeByTrialDivision,
+              "primes around 2^40");
+}
+
+// Far enough up that most sieving primes hit a segment at most once, so
+// these windows are sieved through the buckets.
+void TestBucketedStarts() {
+  Check(IsPrimeByMillerRabin(1000000007), "10^9 + 7 is prime");
+  Check(!IsPrimeByMillerRabin(3215031751ull), "a strong pseudoprime to 2-7");
+
+  uint64_t start = (uint64_t)1 << 50;
+  uint64_t segment_span = 16 * PRIME_SIEVE_SEGMENT_BYTES;
+  CheckWindow(start, start, start + 3 * segment_span, IsPrimeByMillerRabin,
+              "primes after 2^50");
+  CheckWindow(start, start + 40 * segment_span, start + 41 * segment_span,
+              IsPrimeByMillerRabin, "primes 40 segments after 2^50");
+
+  start = (uint64_t)1 << 56;
+  CheckWindow(start, start, start + segment_span, IsPrimeByMillerRabin,
+              "primes after 2^56");
+}
+
+// Checks that the parallel sieve produces the same primes as the single
+// threaded one, which also stops the parallel sieve part way through.
+void CheckParallelMatches(uint64_t start, int num_primes, int num_threads,
+                          char* message) {
+  PrimeSieve sieve;
+  PrimeSieveInit(start, &default_sizes, &sieve);
+  ParallelPrimeSieve parallel_sieve;
+  ParallelPrimeSieveInit(start, num_threads, &default_sizes,
+                         &parallel_sieve);
+  int i;
+  for (i = 0; i < num_primes; i++) {
+    Check(PrimeSieveNext(&sieve) == ParallelPrimeSieveNext(&parallel_sieve),
+          message);
+  }
+  ParallelPrimeSieveFree(&parallel_sieve);
+  PrimeSieveFree(&sieve);
+}
+
+void TestParallel() {
+  CheckParallelMatches(0, 1000000, 1, "one thread from 0");
+  CheckParallelMatches(0, 1000000, 3, "three threads from 0");
+  CheckParallelMatches(1000000000000ull, 200000, 8, "eight threads from 10^12");
+  CheckParallelMatches(((uint64_t)1 << 40) + 1, 100000, 5,
+                       "five threads from 2^40 + 1");
+
+  ParallelPrimeSieve sieve;
+  ParallelPrimeSieveInit(0, 4, &default_sizes, &sieve);
+  int count = 0;
+  while (ParallelPrimeSieveNext(&sieve) < 10000000) {
+    count++;
+  }
+  Check(count == 664579, "four threads find 664579 primes below 10^7");
+  ParallelPrimeSieveFree(&sieve);
+
+  // The largest segments would need a far bigger buffer than the cap with
+  // full length runs, so the runs are cut short.
+  PrimeSieveSizes large_sizes = {1 << 24, PRIME_SIEVE_BUCKET_BYTES};
+  ParallelPrimeSieveInit(1000000000000ull, 2, &large_sizes, &sieve);
+  Check((uint64_t)sieve.window_ * sieve.sizes_.segment_bytes_ <=
+            PRIME_SIEVE_MAX_WINDOW_BYTES,
+        "the buffer of sieved segments is capped");
+  Check(ParallelPrimeSieveNext(&sieve) == 1000000000039ull,
+        "the first prime with a capped buffer");
+  ParallelPrimeSieveFree(&sieve);
+
+  // Stopping straight away must not wait on the rest of the range.
+  ParallelPrimeSieveInit(1000, 0, NULL, &sieve);
+  Check(ParallelPrimeSieveNext(&sieve) == 1009, "first prime after 1000");
+  ParallelPrimeSieveFree(&sieve);
+}
+
+int IsPowerOfTwo(int n) {
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+void TestSizes() {
+  PrimeSieveSizes sizes;
+  PrimeSieveDetectSizes(&sizes);
+  Check(IsPowerOfTwo(sizes.segment_bytes_), "segment size is a power of two");
+  Check(IsPowerOfTwo(sizes.bucket_bytes_), "bucket size is a power of two");
+
+  // The smallest sizes put most sieving primes in buckets and cross many
+  // segment boundaries.
+  PrimeSieveSizes small_sizes = {1024, 1024};
+  uint64_t starts[] = {0, ((uint64_t)1 << 40) - 5000};
+  int i, j;
+  for (i = 0; i < (int)(sizeof(starts) / sizeof(starts[0])); i++) {
+    PrimeSieve sieve;
+    PrimeSieveInit(starts[i], &default_sizes, &sieve);
+    PrimeSieve small_sieve;
+    PrimeSieveInit(starts[i], &small_sizes, &small_sieve);
+    ParallelPrimeSieve parallel_sieve;
+    ParallelPrimeSieveInit(starts[i], 3, &small_sizes, &parallel_sieve);
+    for (j = 0; j < 100000; j++) {
+      uint64_t prime = PrimeSieveNext(&sieve);
+      Check(PrimeSieveNext(&small_sieve) == prime, "small segments");
+      Check(ParallelPrimeSieveNext(&parallel_sieve) == prime,
+            "small segments on three threads");
+    }
+    ParallelPrimeSieveFree(&parallel_sieve);
+    PrimeSieveFree(&small_sieve);
+    PrimeSieveFree(&sieve);
+  }
+}
+
+int main() {
+  TestFirstPrimes();
+  TestPrimeCount();
+  TestLargeStarts();
+  TestBucketedStarts();
+  TestParallel();
+  TestSizes();
+  printf("All tests passed\n");
+}
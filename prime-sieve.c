@@ -0,0 +1,981 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Needed for clock_gettime and sysconf under -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include "prime-sieve.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Sieving primes are found in blocks of this many odd numbers when the table
+// needs to grow.
+#define PRIMES_BLOCK_BITS (1 << 20)
+
+// The odd primes up to this bound are enough to sieve any block of sieving
+// primes, since those are all below 2^32.
+#define BASE_PRIMES_LIMIT 65536
+
+// The smallest odd primes are crossed off by copying in a pattern which
+// repeats every PATTERN_PERIOD odd values, rather than one multiple at a
+// time.
+#define NUM_PATTERN_PRIMES 5
+#define PATTERN_PERIOD (3 * 5 * 7 * 11 * 13)
+
+static const uint32_t PATTERN_PRIMES[NUM_PATTERN_PRIMES] = {3, 5, 7, 11, 13};
+
+// A worker which starts a run away from its last segment recomputes the
+// offsets of all of its sieving primes. Runs cover at least this many bits
+// per sieving prime, which keeps that to a small part of sieving the run,
+// but no fewer than MIN_RUN_SEGMENTS segments and no more than MAX_RUN_BYTES
+// of bitsets.
+#define RUN_BITS_PER_SIEVING_PRIME 64
+#define MIN_RUN_SEGMENTS 8
+#define MAX_RUN_BYTES (1 << 24)
+
+// The reorder buffer holds this many runs per worker. With many threads the
+// runs are shortened, down to a single segment, to keep the buffer within
+// PRIME_SIEVE_MAX_WINDOW_BYTES rather than letting it grow with the thread
+// count.
+#define WINDOW_RUNS_PER_WORKER 2
+
+// Sizes outside of these bounds are not used.
+#define MIN_SEGMENT_BYTES 1024
+#define MAX_SEGMENT_BYTES (1 << 24)
+#define MIN_BUCKET_BYTES 1024
+#define MAX_BUCKET_BYTES (1 << 20)
+
+// The sysfs directory listing the caches of the first processor.
+#define CACHE_DIRECTORY "/sys/devices/system/cpu/cpu0/cache"
+
+static void ErrorOut(char* message) {
+  fprintf(stderr, "%s\n", message);
+  exit(1);
+}
+
+static int IsPowerOfTwo(int n) {
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+static int RoundDownToPowerOfTwo(int n) {
+  int result = 1;
+  while (result <= n / 2) {
+    result *= 2;
+  }
+  return result;
+}
+
+static int Log2(int power_of_two) {
+  return __builtin_ctz(power_of_two);
+}
+
+// Reads the size in bytes of the cache at the given level whose type is type
+// or "Unified". Returns 0 if there is no such cache listed.
+static int ReadCacheSize(int level, char* type) {
+  int index;
+  for (index = 0; index < 16; index++) {
+    char path[100];
+    char cache_type[20];
+    int cache_level;
+    int size;
+    char unit = 0;
+
+    snprintf(path, sizeof(path), "%s/index%d/level", CACHE_DIRECTORY, index);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+      break;
+    }
+    int found = fscanf(file, "%d", &cache_level) == 1;
+    fclose(file);
+    if (!found || cache_level != level) {
+      continue;
+    }
+
+    snprintf(path, sizeof(path), "%s/index%d/type", CACHE_DIRECTORY, index);
+    file = fopen(path, "r");
+    if (file == NULL) {
+      continue;
+    }
+    found = fscanf(file, "%19s", cache_type) == 1;
+    fclose(file);
+    if (!found || (strcmp(cache_type, type) != 0 &&
+                   strcmp(cache_type, "Unified") != 0)) {
+      continue;
+    }
+
+    snprintf(path, sizeof(path), "%s/index%d/size", CACHE_DIRECTORY, index);
+    file = fopen(path, "r");
+    if (file == NULL) {
+      continue;
+    }
+    found = fscanf(file, "%d%c", &size, &unit) >= 1;
+    fclose(file);
+    if (!found || size <= 0) {
+      continue;
+    }
+    uint64_t bytes = size;
+    if (unit == 'K') {
+      bytes <<= 10;
+    } else if (unit == 'M') {
+      bytes <<= 20;
+    }
+    return bytes > (1 << 30) ? 1 << 30 : bytes;
+  }
+  return 0;
+}
+
+void PrimeSieveDetectSizes(PrimeSieveSizes* sizes) {
+  sizes->segment_bytes_ = PRIME_SIEVE_SEGMENT_BYTES;
+  sizes->bucket_bytes_ = PRIME_SIEVE_BUCKET_BYTES;
+
+  int l1_bytes = ReadCacheSize(1, "Data");
+  if (l1_bytes >= MIN_SEGMENT_BYTES) {
+    sizes->segment_bytes_ = RoundDownToPowerOfTwo(l1_bytes);
+    if (sizes->segment_bytes_ > MAX_SEGMENT_BYTES) {
+      sizes->segment_bytes_ = MAX_SEGMENT_BYTES;
+    }
+  }
+  int l2_bytes = ReadCacheSize(2, "Data");
+  if (l2_bytes / 256 >= MIN_BUCKET_BYTES) {
+    sizes->bucket_bytes_ = RoundDownToPowerOfTwo(l2_bytes / 256);
+    if (sizes->bucket_bytes_ > MAX_BUCKET_BYTES) {
+      sizes->bucket_bytes_ = MAX_BUCKET_BYTES;
+    }
+  }
+}
+
+// Fills in sizes from the requested sizes, or detects them if there are
+// none. Sizes given explicitly have to be usable as they are.
+static void ChooseSizes(const PrimeSieveSizes* requested,
+                        PrimeSieveSizes* sizes) {
+  if (requested == NULL) {
+    PrimeSieveDetectSizes(sizes);
+    return;
+  }
+  if (!IsPowerOfTwo(requested->segment_bytes_) ||
+      requested->segment_bytes_ < MIN_SEGMENT_BYTES ||
+      requested->segment_bytes_ > MAX_SEGMENT_BYTES) {
+    ErrorOut("The segment size must be a power of two from 1KB to 16MB.");
+  }
+  if (!IsPowerOfTwo(requested->bucket_bytes_) ||
+      requested->bucket_bytes_ < MIN_BUCKET_BYTES ||
+      requested->bucket_bytes_ > MAX_BUCKET_BYTES) {
+    ErrorOut("The bucket size must be a power of two from 1KB to 1MB.");
+  }
+  *sizes = *requested;
+}
+
+// The largest integer whose square is at most n.
+static uint64_t SquareRoot(uint64_t n) {
+  uint64_t root = 0;
+  uint64_t bit;
+  for (bit = (uint64_t)1 << 31; bit > 0; bit >>= 1) {
+    uint64_t trial = root | bit;
+    if (trial * trial <= n) {
+      root = trial;
+    }
+  }
+  return root;
+}
+
+// Finds the bit index, relative to the odd value low, of the first odd
+// multiple of p which is at least p * p and at least low. Multiples past the
+// top of the 64 bit range give an index no segment will reach.
+static uint64_t FirstMultiple(uint32_t p, uint64_t low) {
+  unsigned __int128 multiple = (unsigned __int128)p * p;
+  if (multiple < low) {
+    uint64_t remainder = low % p;
+    multiple = low;
+    if (remainder != 0) {
+      multiple += p - remainder;
+    }
+    if ((multiple & 1) == 0) {
+      multiple += p;
+    }
+  }
+  unsigned __int128 index = (multiple - low) / 2;
+  if (index > UINT64_MAX / 2) {
+    return UINT64_MAX / 2;
+  }
+  return (uint64_t)index;
+}
+
+static void AddSievingPrime(uint32_t p, SievingPrimes* this) {
+  if (this->num_primes_ == this->capacity_) {
+    int capacity = this->capacity_ * 2;
+    if (capacity == 0) {
+      capacity = 1024;
+    }
+    this->primes_ = realloc(this->primes_, capacity * sizeof(uint32_t));
+    if (this->primes_ == NULL) {
+      ErrorOut("Unable to allocate space for sieving primes.");
+    }
+    this->capacity_ = capacity;
+  }
+  this->primes_[this->num_primes_] = p;
+  this->num_primes_++;
+}
+
+// Adds the odd primes up to BASE_PRIMES_LIMIT with a plain sieve.
+static void AddBasePrimes(SievingPrimes* this) {
+  char* is_composite = calloc(BASE_PRIMES_LIMIT + 1, 1);
+  if (is_composite == NULL) {
+    ErrorOut("Unable to allocate space for sieving primes.");
+  }
+  uint32_t i, j;
+  for (i = 3; i <= BASE_PRIMES_LIMIT; i += 2) {
+    if (is_composite[i]) {
+      continue;
+    }
+    AddSievingPrime(i, this);
+    for (j = i * i; j <= BASE_PRIMES_LIMIT; j += 2 * i) {
+      is_composite[j] = 1;
+    }
+  }
+  free(is_composite);
+  this->limit_ = BASE_PRIMES_LIMIT;
+}
+
+static void InitSievingPrimes(SievingPrimes* this) {
+  this->primes_ = NULL;
+  this->num_primes_ = 0;
+  this->capacity_ = 0;
+  this->limit_ = 0;
+}
+
+// Makes sure every odd prime up to limit is in the table of sieving primes.
+// New primes are found a block at a time with a small sieve of their own,
+// using the primes already in the table.
+static void GrowSievingPrimes(uint64_t limit, SievingPrimes* this) {
+  if (this->limit_ == 0) {
+    AddBasePrimes(this);
+  }
+  if (limit > UINT32_MAX) {
+    limit = UINT32_MAX;
+  }
+
+  uint8_t* block = NULL;
+  while (this->limit_ < limit) {
+    if (block == NULL) {
+      block = malloc(PRIMES_BLOCK_BITS);
+      if (block == NULL) {
+        ErrorOut("Unable to allocate space for sieving primes.");
+      }
+    }
+    // The block covers the odd numbers from block_low up to block_high.
+    uint64_t block_low = this->limit_ + 1;
+    if ((block_low & 1) == 0) {
+      block_low++;
+    }
+    uint64_t block_high = block_low + 2 * (PRIMES_BLOCK_BITS - 1);
+    if (block_high > UINT32_MAX) {
+      block_high = UINT32_MAX;
+    }
+    int block_bits = (block_high - block_low) / 2 + 1;
+    memset(block, 1, block_bits);
+
+    int i;
+    for (i = 0; i < this->num_primes_; i++) {
+      uint64_t p = this->primes_[i];
+      if (p * p > block_high) {
+        break;
+      }
+      uint64_t j;
+      for (j = FirstMultiple(p, block_low); j < (uint64_t)block_bits; j += p) {
+        block[j] = 0;
+      }
+    }
+    for (i = 0; i < block_bits; i++) {
+      if (block[i]) {
+        AddSievingPrime(block_low + 2 * i, this);
+      }
+    }
+    this->limit_ = block_high;
+  }
+  free(block);
+}
+
+static void InitSieveOffsets(const PrimeSieveSizes* sizes,
+                             SieveOffsets* this) {
+  this->segment_shift_ = Log2(8 * sizes->segment_bytes_);
+  this->bucket_entries_ = sizes->bucket_bytes_ / sizeof(BucketEntry);
+  this->low_ = 0;
+  this->num_primes_ = 0;
+  this->offsets_ = NULL;
+  this->num_offsets_ = 0;
+  this->capacity_ = 0;
+  this->buckets_ = NULL;
+  this->num_buckets_ = 0;
+  this->segment_ = 0;
+  this->free_blocks_ = NULL;
+}
+
+static void FreeBucketBlocks(BucketBlock* block) {
+  while (block != NULL) {
+    BucketBlock* next = block->next_;
+    free(block);
+    block = next;
+  }
+}
+
+static void FreeSieveOffsets(SieveOffsets* this) {
+  int i;
+  for (i = 0; i < this->num_buckets_; i++) {
+    FreeBucketBlocks(this->buckets_[i]);
+  }
+  FreeBucketBlocks(this->free_blocks_);
+  free(this->buckets_);
+  free(this->offsets_);
+  this->buckets_ = NULL;
+  this->num_buckets_ = 0;
+  this->offsets_ = NULL;
+  this->free_blocks_ = NULL;
+}
+
+// Moves every block in the buckets on to the free list.
+static void EmptyBuckets(SieveOffsets* this) {
+  int i;
+  for (i = 0; i < this->num_buckets_; i++) {
+    BucketBlock* block = this->buckets_[i];
+    while (block != NULL) {
+      BucketBlock* next = block->next_;
+      block->next_ = this->free_blocks_;
+      this->free_blocks_ = block;
+      block = next;
+    }
+    this->buckets_[i] = NULL;
+  }
+}
+
+// Files a large prime in the bucket for the segment it hits next, counting
+// segments from the one at low_ when the offsets were last recomputed.
+static void FileInBucket(uint32_t prime, uint64_t segment, uint32_t offset,
+                         SieveOffsets* this) {
+  if (this->buckets_ == NULL) {
+    // A large prime moves on by at most this many segments at a time.
+    int max_step = (UINT32_MAX >> this->segment_shift_) + 1;
+    int num_buckets = 1;
+    while (num_buckets <= max_step) {
+      num_buckets *= 2;
+    }
+    this->buckets_ = calloc(num_buckets, sizeof(BucketBlock*));
+    if (this->buckets_ == NULL) {
+      ErrorOut("Unable to allocate space for sieve buckets.");
+    }
+    this->num_buckets_ = num_buckets;
+  }
+
+  BucketBlock** bucket = &this->buckets_[segment & (this->num_buckets_ - 1)];
+  BucketBlock* block = *bucket;
+  if (block == NULL ||
+      block->num_entries_ == this->bucket_entries_) {
+    BucketBlock* new_block = this->free_blocks_;
+    if (new_block != NULL) {
+      this->free_blocks_ = new_block->next_;
+    } else {
+      new_block = malloc(sizeof(BucketBlock) +
+                         this->bucket_entries_ * sizeof(BucketEntry));
+      if (new_block == NULL) {
+        ErrorOut("Unable to allocate space for sieve buckets.");
+      }
+    }
+    new_block->next_ = block;
+    new_block->num_entries_ = 0;
+    *bucket = new_block;
+    block = new_block;
+  }
+  block->entries_[block->num_entries_].prime_ = prime;
+  block->entries_[block->num_entries_].offset_ = offset;
+  block->num_entries_++;
+}
+
+// Moves the offsets to the segment of bits odd values starting at low and
+// brings in any sieving primes whose squares the segment reaches.
+static void PrepareSieveOffsets(const SievingPrimes* sieving_primes,
+                                uint64_t low, int bits, SieveOffsets* this) {
+  if (this->low_ != low) {
+    // Start over from this segment.
+    EmptyBuckets(this);
+    this->low_ = low;
+    this->num_primes_ = 0;
+    this->num_offsets_ = 0;
+    this->segment_ = 0;
+  }
+
+  uint64_t high = low + 2 * (uint64_t)(bits - 1);
+  uint64_t segment_bits = (uint64_t)1 << this->segment_shift_;
+  while (this->num_primes_ < sieving_primes->num_primes_) {
+    uint64_t p = sieving_primes->primes_[this->num_primes_];
+    if (p * p > high) {
+      break;
+    }
+    uint64_t offset = FirstMultiple(p, low);
+    if (p < segment_bits) {
+      if (this->num_offsets_ == this->capacity_) {
+        this->capacity_ = this->capacity_ == 0 ? 1024 : 2 * this->capacity_;
+        this->offsets_ = realloc(this->offsets_,
+                                 this->capacity_ * sizeof(uint64_t));
+        if (this->offsets_ == NULL) {
+          ErrorOut("Unable to allocate space for sieving offsets.");
+        }
+      }
+      this->offsets_[this->num_offsets_] = offset;
+      this->num_offsets_++;
+    } else {
+      FileInBucket(p, this->segment_ + (offset >> this->segment_shift_),
+                   offset & (segment_bits - 1), this);
+    }
+    this->num_primes_++;
+  }
+}
+
+// Builds the pattern, in which bit i is set if 2 * i + 1 has none of the
+// pattern primes as a factor. It holds 64 periods, so a copy at any phase
+// can start on a word boundary, and then enough for a whole segment.
+static uint64_t* CreatePattern(const PrimeSieveSizes* sizes) {
+  int num_words = PATTERN_PERIOD + sizes->segment_bytes_ / 8;
+  uint64_t* pattern = calloc(num_words, sizeof(uint64_t));
+  if (pattern == NULL) {
+    ErrorOut("Unable to allocate space for the sieve pattern.");
+  }
+  int i, j;
+  for (i = 0; i < 64 * num_words; i++) {
+    uint64_t value = 2 * (uint64_t)i + 1;
+    for (j = 0; j < NUM_PATTERN_PRIMES; j++) {
+      if (value % PATTERN_PRIMES[j] == 0) {
+        break;
+      }
+    }
+    if (j == NUM_PATTERN_PRIMES) {
+      pattern[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+  }
+  return pattern;
+}
+
+// Sieves the segment of bits odd values starting at the offsets' low value,
+// leaving the primes set in words. The offsets move on to the segment right
+// after this one.
+static void SieveSegment(const uint64_t* pattern,
+                         const SievingPrimes* sieving_primes, int bits,
+                         SieveOffsets* offsets, uint64_t* words) {
+  // Start from the pattern at the phase of low_, moved along by whole periods
+  // until the copy starts on a word.
+  uint64_t low = offsets->low_;
+  uint64_t phase = (low / 2) % PATTERN_PERIOD;
+  while (phase % 64 != 0) {
+    phase += PATTERN_PERIOD;
+  }
+  int num_words = (bits + 63) / 64;
+  memcpy(words, &pattern[phase / 64], num_words * sizeof(uint64_t));
+  if (bits % 64 != 0) {
+    words[num_words - 1] &= ((uint64_t)1 << (bits % 64)) - 1;
+  }
+  if (low == 1) {
+    // 1 is not prime.
+    words[0] &= ~(uint64_t)1;
+  }
+  int i;
+  for (i = 0; i < NUM_PATTERN_PRIMES; i++) {
+    // The pattern crosses off the pattern primes themselves.
+    uint64_t p = PATTERN_PRIMES[i];
+    if (p >= low && (p - low) / 2 < (uint64_t)bits) {
+      words[0] |= (uint64_t)1 << ((p - low) / 2);
+    }
+  }
+
+  // The offsets of the pattern primes are left as they are, since they are
+  // never used.
+  for (i = NUM_PATTERN_PRIMES; i < offsets->num_offsets_; i++) {
+    uint64_t p = sieving_primes->primes_[i];
+    uint64_t j = offsets->offsets_[i];
+    for (; j < (uint64_t)bits; j += p) {
+      words[j / 64] &= ~((uint64_t)1 << (j % 64));
+    }
+    offsets->offsets_[i] = j - bits;
+  }
+
+  if (offsets->num_buckets_ > 0) {
+    int index = offsets->segment_ & (offsets->num_buckets_ - 1);
+    BucketBlock* block = offsets->buckets_[index];
+    offsets->buckets_[index] = NULL;
+    while (block != NULL) {
+      for (i = 0; i < block->num_entries_; i++) {
+        uint32_t p = block->entries_[i].prime_;
+        uint64_t j = block->entries_[i].offset_;
+        // Only the last segment is short, and hits past it are past 2^64.
+        if (j < (uint64_t)bits) {
+          words[j / 64] &= ~((uint64_t)1 << (j % 64));
+        }
+        j += p;
+        FileInBucket(p, offsets->segment_ + (j >> offsets->segment_shift_),
+                     j & (((uint64_t)1 << offsets->segment_shift_) - 1),
+                     offsets);
+      }
+      BucketBlock* next = block->next_;
+      block->next_ = offsets->free_blocks_;
+      offsets->free_blocks_ = block;
+      block = next;
+    }
+  }
+
+  // Past the last segment this wraps, but then it is never used.
+  offsets->low_ += 2 * (uint64_t)bits;
+  offsets->segment_++;
+}
+
+// Finds the first set bit at or after from, or returns -1 if there is none.
+static int NextSetBit(const uint64_t* words, int bits, int from) {
+  int num_words = (bits + 63) / 64;
+  int word_index = from / 64;
+  if (word_index >= num_words) {
+    return -1;
+  }
+  uint64_t word = words[word_index] >> (from % 64);
+  if (word != 0) {
+    return from + __builtin_ctzll(word);
+  }
+  for (word_index++; word_index < num_words; word_index++) {
+    if (words[word_index] != 0) {
+      return 64 * word_index + __builtin_ctzll(words[word_index]);
+    }
+  }
+  return -1;
+}
+
+// Moves on to the next segment and sieves it. Returns 0 if the previous
+// segment already reached the end of the 64 bit range.
+static int SieveNextSegment(PrimeSieve* this) {
+  if (this->last_segment_) {
+    return 0;
+  }
+  if (this->segment_bits_ > 0) {
+    this->low_ += 2 * (uint64_t)this->segment_bits_;
+  }
+
+  int bits = 8 * this->sizes_.segment_bytes_;
+  if ((UINT64_MAX - this->low_) / 2 < (uint64_t)(bits - 1)) {
+    bits = (UINT64_MAX - this->low_) / 2 + 1;
+    this->last_segment_ = 1;
+  }
+  uint64_t high = this->low_ + 2 * (uint64_t)(bits - 1);
+  GrowSievingPrimes(SquareRoot(high), &this->sieving_primes_);
+  PrepareSieveOffsets(&this->sieving_primes_, this->low_, bits,
+                      &this->offsets_);
+  SieveSegment(this->pattern_, &this->sieving_primes_, bits, &this->offsets_,
+               this->segment_);
+
+  this->segment_bits_ = bits;
+  this->next_bit_ = 0;
+  return 1;
+}
+
+void PrimeSieveInit(uint64_t start, const PrimeSieveSizes* sizes,
+                    PrimeSieve* this) {
+  ChooseSizes(sizes, &this->sizes_);
+  this->start_ = start;
+  this->low_ = start | 1;
+  this->segment_ = malloc(this->sizes_.segment_bytes_);
+  if (this->segment_ == NULL) {
+    ErrorOut("Unable to allocate space for a sieve segment.");
+  }
+  this->pattern_ = CreatePattern(&this->sizes_);
+  this->segment_bits_ = 0;
+  this->next_bit_ = 0;
+  this->last_segment_ = 0;
+  this->reported_two_ = start > 2;
+  InitSievingPrimes(&this->sieving_primes_);
+  InitSieveOffsets(&this->sizes_, &this->offsets_);
+}
+
+void PrimeSieveFree(PrimeSieve* this) {
+  free(this->segment_);
+  free(this->sieving_primes_.primes_);
+  FreeSieveOffsets(&this->offsets_);
+  free(this->pattern_);
+  this->segment_ = NULL;
+  this->pattern_ = NULL;
+  this->sieving_primes_.primes_ = NULL;
+}
+
+uint64_t PrimeSieveNext(PrimeSieve* this) {
+  if (!this->reported_two_) {
+    this->reported_two_ = 1;
+    return 2;
+  }
+
+  while (1) {
+    int bit = NextSetBit(this->segment_, this->segment_bits_, this->next_bit_);
+    if (bit >= 0) {
+      this->next_bit_ = bit + 1;
+      return this->low_ + 2 * (uint64_t)bit;
+    }
+    if (!SieveNextSegment(this)) {
+      return 0;
+    }
+  }
+}
+
+static double Seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Roughly how many sieving primes a segment reaching high needs, using
+// n / ln(n) for the number of primes up to n.
+static uint64_t EstimateSievingPrimes(uint64_t high) {
+  uint64_t root = SquareRoot(high);
+  if (root < 16) {
+    return 1;
+  }
+  int log2 = 63 - __builtin_clzll(root);
+  return root * 10 / (7 * log2);
+}
+
+static uint64_t SegmentLow(uint64_t segment, const ParallelPrimeSieve* this) {
+  return this->base_ + 16 * (uint64_t)this->sizes_.segment_bytes_ * segment;
+}
+
+static int SegmentBits(uint64_t segment, const ParallelPrimeSieve* this) {
+  uint64_t segment_bits = 8 * this->sizes_.segment_bytes_;
+  uint64_t remaining = this->num_bits_ - segment_bits * segment;
+  if (remaining < segment_bits) {
+    return remaining;
+  }
+  return segment_bits;
+}
+
+// Finds where the words of the segment in the given slot of the window are.
+static uint64_t* WindowWords(int slot, const ParallelPrimeSieve* this) {
+  uint64_t words_per_segment = this->sizes_.segment_bytes_ / 8;
+  return &this->window_words_[slot * words_per_segment];
+}
+
+// Takes the back half of the run of the worker with the most segments left.
+// Returns 0 if no worker has enough left to share.
+static int StealSegments(PrimeSieveWorker* thief) {
+  ParallelPrimeSieve* sieve = thief->sieve_;
+  PrimeSieveWorker* victim = NULL;
+  uint64_t most_remaining = 1;
+  int i;
+  for (i = 0; i < sieve->num_workers_; i++) {
+    PrimeSieveWorker* worker = &sieve->workers_[i];
+    if (worker == thief) {
+      continue;
+    }
+    pthread_mutex_lock(&worker->lock_);
+    uint64_t remaining = worker->end_segment_ - worker->next_segment_;
+    pthread_mutex_unlock(&worker->lock_);
+    if (remaining > most_remaining) {
+      victim = worker;
+      most_remaining = remaining;
+    }
+  }
+  if (victim == NULL) {
+    return 0;
+  }
+
+  uint64_t begin, end;
+  pthread_mutex_lock(&victim->lock_);
+  end = victim->end_segment_;
+  begin = end - (end - victim->next_segment_) / 2;
+  victim->end_segment_ = begin;
+  pthread_mutex_unlock(&victim->lock_);
+  if (begin == end) {
+    // The victim worked through its run while we were looking.
+    return 0;
+  }
+
+  pthread_mutex_lock(&thief->lock_);
+  thief->next_segment_ = begin;
+  thief->end_segment_ = end;
+  pthread_mutex_unlock(&thief->lock_);
+  return 1;
+}
+
+// Gives the worker a new run from the unassigned segments, waiting for the
+// window to move if it is full. Returns 0 once every segment has been given
+// out or the sieve is stopping.
+static int AssignSegments(PrimeSieveWorker* worker) {
+  ParallelPrimeSieve* sieve = worker->sieve_;
+  pthread_mutex_lock(&sieve->lock_);
+  uint64_t window_end = sieve->next_to_read_ + sieve->window_;
+  if (sieve->stopping_ || sieve->next_unassigned_ == sieve->num_segments_) {
+    pthread_mutex_unlock(&sieve->lock_);
+    return 0;
+  }
+  if (sieve->next_unassigned_ == window_end) {
+    // Wait for the reader, then look for work to steal again.
+    pthread_cond_wait(&sieve->window_moved_, &sieve->lock_);
+    pthread_mutex_unlock(&sieve->lock_);
+    return 1;
+  }
+
+  uint64_t begin = sieve->next_unassigned_;
+  uint64_t end = begin + sieve->run_segments_;
+  if (end > window_end) {
+    end = window_end;
+  }
+  if (end > sieve->num_segments_) {
+    end = sieve->num_segments_;
+  }
+  sieve->next_unassigned_ = end;
+  pthread_mutex_unlock(&sieve->lock_);
+
+  pthread_mutex_lock(&worker->lock_);
+  worker->next_segment_ = begin;
+  worker->end_segment_ = end;
+  pthread_mutex_unlock(&worker->lock_);
+  return 1;
+}
+
+// Picks the worker's next segment, first from its own run, then by stealing
+// and then from the unassigned segments. Returns 0 when there is no more
+// work.
+static int TakeSegment(PrimeSieveWorker* worker, uint64_t* segment) {
+  while (1) {
+    pthread_mutex_lock(&worker->lock_);
+    int found = worker->next_segment_ < worker->end_segment_;
+    if (found) {
+      *segment = worker->next_segment_;
+      worker->next_segment_++;
+    }
+    pthread_mutex_unlock(&worker->lock_);
+    if (found) {
+      return 1;
+    }
+    if (!StealSegments(worker) && !AssignSegments(worker)) {
+      return 0;
+    }
+  }
+}
+
+// Sieves the segment with the worker's own offsets in to its slot of the
+// window.
+static void SieveWorkerSegment(uint64_t segment, PrimeSieveWorker* worker) {
+  ParallelPrimeSieve* sieve = worker->sieve_;
+  uint64_t low = SegmentLow(segment, sieve);
+  int bits = SegmentBits(segment, sieve);
+  uint64_t limit = SquareRoot(low + 2 * (uint64_t)(bits - 1));
+  int slot = segment % sieve->window_;
+  uint64_t* words = WindowWords(slot, sieve);
+  double start = Seconds();
+
+  GrowSievingPrimes(limit, &worker->sieving_primes_);
+  PrepareSieveOffsets(&worker->sieving_primes_, low, bits,
+                      &worker->offsets_);
+  SieveSegment(sieve->pattern_, &worker->sieving_primes_, bits,
+               &worker->offsets_, words);
+
+  uint64_t primes_found = 0;
+  int i;
+  for (i = 0; i < (bits + 63) / 64; i++) {
+    primes_found += __builtin_popcountll(words[i]);
+  }
+  double seconds = Seconds() - start;
+
+  pthread_mutex_lock(&sieve->lock_);
+  sieve->window_bits_[slot] = bits;
+  worker->segments_sieved_++;
+  worker->primes_found_ += primes_found;
+  worker->seconds_busy_ += seconds;
+  if (segment == sieve->next_to_read_) {
+    pthread_cond_signal(&sieve->segment_ready_);
+  }
+  pthread_mutex_unlock(&sieve->lock_);
+}
+
+static void* RunWorker(void* argument) {
+  PrimeSieveWorker* worker = argument;
+  uint64_t segment;
+  while (TakeSegment(worker, &segment)) {
+    SieveWorkerSegment(segment, worker);
+  }
+  return NULL;
+}
+
+void ParallelPrimeSieveInit(uint64_t start, int num_threads,
+                            const PrimeSieveSizes* sizes,
+                            ParallelPrimeSieve* this) {
+  if (num_threads <= 0) {
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads <= 0) {
+      num_threads = 1;
+    }
+  }
+
+  ChooseSizes(sizes, &this->sizes_);
+  uint64_t segment_bits = 8 * this->sizes_.segment_bytes_;
+  this->base_ = start | 1;
+  this->num_bits_ = (UINT64_MAX - this->base_) / 2 + 1;
+  this->num_segments_ = (this->num_bits_ + segment_bits - 1) / segment_bits;
+  this->reported_two_ = start > 2;
+  this->pattern_ = CreatePattern(&this->sizes_);
+
+  pthread_mutex_init(&this->lock_, NULL);
+  pthread_cond_init(&this->segment_ready_, NULL);
+  pthread_cond_init(&this->window_moved_, NULL);
+  this->next_unassigned_ = 0;
+  this->next_to_read_ = 0;
+  this->stopping_ = 0;
+  this->start_seconds_ = Seconds();
+  uint64_t run_bits = RUN_BITS_PER_SIEVING_PRIME *
+                      EstimateSievingPrimes(this->base_);
+  this->run_segments_ = run_bits / segment_bits;
+  if (this->run_segments_ > MAX_RUN_BYTES / this->sizes_.segment_bytes_) {
+    this->run_segments_ = MAX_RUN_BYTES / this->sizes_.segment_bytes_;
+  }
+  if (this->run_segments_ < MIN_RUN_SEGMENTS) {
+    this->run_segments_ = MIN_RUN_SEGMENTS;
+  }
+  uint64_t max_run_segments = PRIME_SIEVE_MAX_WINDOW_BYTES /
+      ((uint64_t)num_threads * WINDOW_RUNS_PER_WORKER *
+       this->sizes_.segment_bytes_);
+  if ((uint64_t)this->run_segments_ > max_run_segments) {
+    this->run_segments_ = max_run_segments > 0 ? max_run_segments : 1;
+  }
+  this->window_ = num_threads * this->run_segments_ * WINDOW_RUNS_PER_WORKER;
+  this->window_words_ = malloc((uint64_t)this->window_ *
+                               this->sizes_.segment_bytes_);
+  this->window_bits_ = calloc(this->window_, sizeof(int));
+  if (this->window_words_ == NULL || this->window_bits_ == NULL) {
+    ErrorOut("Unable to allocate space for the sieve's segments.");
+  }
+  this->reading_segment_ = 0;
+  this->next_bit_ = 0;
+
+  this->num_workers_ = num_threads;
+  this->workers_ = malloc(num_threads * sizeof(PrimeSieveWorker));
+  if (this->workers_ == NULL) {
+    ErrorOut("Unable to allocate space for the sieve's threads.");
+  }
+  int i;
+  for (i = 0; i < num_threads; i++) {
+    PrimeSieveWorker* worker = &this->workers_[i];
+    worker->sieve_ = this;
+    pthread_mutex_init(&worker->lock_, NULL);
+    worker->next_segment_ = 0;
+    worker->end_segment_ = 0;
+    InitSievingPrimes(&worker->sieving_primes_);
+    InitSieveOffsets(&this->sizes_, &worker->offsets_);
+    worker->segments_sieved_ = 0;
+    worker->primes_found_ = 0;
+    worker->seconds_busy_ = 0;
+  }
+  for (i = 0; i < num_threads; i++) {
+    PrimeSieveWorker* worker = &this->workers_[i];
+    if (pthread_create(&worker->thread_, NULL, RunWorker, worker) != 0) {
+      ErrorOut("Unable to start a sieve thread.");
+    }
+  }
+}
+
+void ParallelPrimeSieveFree(ParallelPrimeSieve* this) {
+  pthread_mutex_lock(&this->lock_);
+  this->stopping_ = 1;
+  pthread_cond_broadcast(&this->window_moved_);
+  pthread_mutex_unlock(&this->lock_);
+
+  int i;
+  for (i = 0; i < this->num_workers_; i++) {
+    // Workers finish their current runs before noticing the stop, so clear
+    // the runs first.
+    PrimeSieveWorker* worker = &this->workers_[i];
+    pthread_mutex_lock(&worker->lock_);
+    worker->end_segment_ = worker->next_segment_;
+    pthread_mutex_unlock(&worker->lock_);
+  }
+  for (i = 0; i < this->num_workers_; i++) {
+    pthread_join(this->workers_[i].thread_, NULL);
+  }
+  for (i = 0; i < this->num_workers_; i++) {
+    PrimeSieveWorker* worker = &this->workers_[i];
+    pthread_mutex_destroy(&worker->lock_);
+    free(worker->sieving_primes_.primes_);
+    FreeSieveOffsets(&worker->offsets_);
+  }
+  free(this->workers_);
+  free(this->window_words_);
+  free(this->window_bits_);
+  free(this->pattern_);
+  pthread_cond_destroy(&this->segment_ready_);
+  pthread_cond_destroy(&this->window_moved_);
+  pthread_mutex_destroy(&this->lock_);
+  this->workers_ = NULL;
+  this->window_words_ = NULL;
+  this->window_bits_ = NULL;
+  this->pattern_ = NULL;
+}
+
+uint64_t ParallelPrimeSieveNext(ParallelPrimeSieve* this) {
+  if (!this->reported_two_) {
+    this->reported_two_ = 1;
+    return 2;
+  }
+
+  while (this->next_to_read_ < this->num_segments_) {
+    // Only this thread moves next_to_read_, so it can be read unlocked.
+    int slot = this->next_to_read_ % this->window_;
+    uint64_t* words = WindowWords(slot, this);
+    if (!this->reading_segment_) {
+      pthread_mutex_lock(&this->lock_);
+      while (this->window_bits_[slot] == 0) {
+        pthread_cond_wait(&this->segment_ready_, &this->lock_);
+      }
+      pthread_mutex_unlock(&this->lock_);
+      this->reading_segment_ = 1;
+      this->next_bit_ = 0;
+    }
+
+    int bit = NextSetBit(words, this->window_bits_[slot], this->next_bit_);
+    if (bit >= 0) {
+      this->next_bit_ = bit + 1;
+      return SegmentLow(this->next_to_read_, this) + 2 * (uint64_t)bit;
+    }
+
+    pthread_mutex_lock(&this->lock_);
+    this->window_bits_[slot] = 0;
+    this->next_to_read_++;
+    pthread_cond_broadcast(&this->window_moved_);
+    pthread_mutex_unlock(&this->lock_);
+    this->reading_segment_ = 0;
+  }
+  return 0;
+}
+
+void ParallelPrimeSieveReport(ParallelPrimeSieve* this, FILE* out) {
+  pthread_mutex_lock(&this->lock_);
+  double elapsed = Seconds() - this->start_seconds_;
+  int i;
+  for (i = 0; i < this->num_workers_; i++) {
+    PrimeSieveWorker* worker = &this->workers_[i];
+    double rate = 0;
+    if (worker->seconds_busy_ > 0) {
+      rate = worker->primes_found_ / worker->seconds_busy_;
+    }
+    fprintf(out, "Thread %d: %llu segments, %llu primes, %.0f primes per "
+            "second, busy %.0f%% of %.0f seconds\n", i,
+            (unsigned long long)worker->segments_sieved_,
+            (unsigned long long)worker->primes_found_, rate,
+            elapsed > 0 ? 100 * worker->seconds_busy_ / elapsed : 0, elapsed);
+  }
+  pthread_mutex_unlock(&this->lock_);
+}
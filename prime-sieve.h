@@ -0,0 +1,217 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRIME_SIEVE_H
+#define PRIME_SIEVE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The sizes used when the cache sizes cannot be read. Segments of 32KB stay
+// in the L1 data cache of most processors.
+#define PRIME_SIEVE_SEGMENT_BYTES 32768
+#define PRIME_SIEVE_BUCKET_BYTES 8192
+
+// The most the parallel sieve's buffer of sieved segments may take, however
+// many threads it runs, unless each thread's share is under two segments.
+#define PRIME_SIEVE_MAX_WINDOW_BYTES (1 << 27)
+
+// The sizes of the sieve's working memory, each a power of two.
+typedef struct {
+  int segment_bytes_;  // The bytes in each segment's bitset.
+  int bucket_bytes_;  // The bytes of entries in each block of a bucket.
+} PrimeSieveSizes;
+
+// Chooses sizes from the caches of the first processor, as listed under
+// /sys/devices/system/cpu/cpu0/cache. A segment fills the L1 data cache, so
+// it stays there while it is sieved, and a bucket block is 1/256 of the L2
+// cache, so that the blocks being filled for the next few hundred segments
+// stay in L2. Each size is rounded down to a power of two.
+void PrimeSieveDetectSizes(PrimeSieveSizes* sizes);
+
+// The odd primes used to sieve segments, found as they are needed.
+typedef struct {
+  uint32_t* primes_;  // The odd sieving primes in increasing order.
+  int num_primes_;
+  int capacity_;
+  uint64_t limit_;  // All odd primes up to this are in primes_.
+} SievingPrimes;
+
+// A large sieving prime along with the bit index, within the segment of the
+// bucket it is filed in, of its next odd multiple.
+typedef struct {
+  uint32_t prime_;
+  uint32_t offset_;
+} BucketEntry;
+
+// Buckets are lists of fixed size blocks, which are reused once the segment
+// they were filed for has been sieved.
+typedef struct BucketBlock {
+  struct BucketBlock* next_;
+  int num_entries_;
+  BucketEntry entries_[];
+} BucketBlock;
+
+// Where each sieving prime next hits the segments, starting with the segment
+// whose bit 0 is low_. Moving on to the segment right after the last one
+// sieved keeps these up to date; any other segment has them recomputed.
+//
+// Small primes, which hit every segment, keep the bit index of their next
+// odd multiple relative to low_ in offsets_. Large primes hit a segment at
+// most once, and far from the top of the range most of them miss it
+// entirely, so they are filed in a ring of buckets by the segment they hit
+// next. Sieving a segment then only touches the large primes which hit it.
+typedef struct {
+  int segment_shift_;  // Every segment but the last has 1 << segment_shift_
+                       // bits.
+  int bucket_entries_;  // The entries in each block of a bucket.
+  uint64_t low_;
+  int num_primes_;  // The sieving primes in use, whose squares are reached.
+  uint64_t* offsets_;
+  int num_offsets_;  // The small primes among those in use.
+  int capacity_;
+
+  BucketBlock** buckets_;  // Indexed by segment number modulo num_buckets_.
+  int num_buckets_;
+  uint64_t segment_;  // The number of segments sieved since the offsets were
+                      // last recomputed.
+  BucketBlock* free_blocks_;
+} SieveOffsets;
+
+// A segmented sieve of Eratosthenes which produces the primes from a starting
+// point up through the end of the 64 bit range, in order.
+//
+// Only odd numbers are represented: bit i of the segment stands for
+// low_ + 2 * i. Each segment is sieved by the odd primes up to the square
+// root of its highest value. That table of sieving primes is grown as the
+// segments move up, so a sieve which starts near 2^64 needs every prime below
+// 2^32 while one which starts low needs very few. Each segment starts as a
+// copy of a pattern with the multiples of 3, 5, 7, 11 and 13 already crossed
+// off.
+//
+// A PrimeSieve must be set up with PrimeSieveInit and released with
+// PrimeSieveFree.
+typedef struct {
+  PrimeSieveSizes sizes_;
+  uint64_t start_;  // The smallest value which may be reported.
+  uint64_t low_;  // The odd value of bit 0 in the current segment.
+  uint64_t* segment_;
+  int segment_bits_;  // The number of bits in use in the current segment.
+  int next_bit_;  // Where to resume scanning the current segment.
+  int last_segment_;  // Set once the segment reaching 2^64 - 1 is sieved.
+  int reported_two_;
+  uint64_t* pattern_;
+  SievingPrimes sieving_primes_;
+  SieveOffsets offsets_;
+} PrimeSieve;
+
+// Prepares the sieve to produce primes starting with the smallest prime which
+// is at least start. If sizes is NULL, the sizes are detected with
+// PrimeSieveDetectSizes.
+void PrimeSieveInit(uint64_t start, const PrimeSieveSizes* sizes,
+                    PrimeSieve* this);
+
+// Releases the memory held by the sieve.
+void PrimeSieveFree(PrimeSieve* this);
+
+// Provides the next prime in increasing order. Returns 0 once every prime
+// below 2^64 has been produced.
+uint64_t PrimeSieveNext(PrimeSieve* this);
+
+struct ParallelPrimeSieve;
+
+// One thread of a ParallelPrimeSieve. Each worker owns a run of consecutive
+// segments which it sieves from the front, so its offsets carry over from one
+// segment to the next. A worker which runs out steals the back half of
+// another worker's run.
+//
+// Every worker grows its own table of sieving primes, which is smaller than
+// its offsets and means the threads never wait on each other to sieve.
+typedef struct {
+  struct ParallelPrimeSieve* sieve_;
+  pthread_t thread_;
+  pthread_mutex_t lock_;  // Guards next_segment_ and end_segment_.
+  uint64_t next_segment_;
+  uint64_t end_segment_;
+  SievingPrimes sieving_primes_;
+  SieveOffsets offsets_;
+
+  // Throughput, guarded by the sieve's lock_.
+  uint64_t segments_sieved_;
+  uint64_t primes_found_;
+  double seconds_busy_;
+} PrimeSieveWorker;
+
+// A segmented sieve which spreads the segments over several threads while
+// still producing the primes in increasing order.
+//
+// Sieved segments land in a reorder buffer of window_ slots, where segment k
+// uses slot k % window_. The segment being read sits at the front of the
+// window and no segment past the back of the window is handed out, so
+// workers which finish out of order never overwrite a segment still waiting
+// to be read.
+//
+// A ParallelPrimeSieve must be set up with ParallelPrimeSieveInit and
+// released with ParallelPrimeSieveFree.
+typedef struct ParallelPrimeSieve {
+  PrimeSieveSizes sizes_;
+  uint64_t base_;  // The odd value of bit 0 in segment 0.
+  uint64_t num_bits_;  // The number of odd values from base_ to 2^64 - 1.
+  uint64_t num_segments_;
+  int reported_two_;
+  uint64_t* pattern_;  // Shared by the workers, which only read it.
+  int run_segments_;  // The segments given to a worker at a time.
+
+  int num_workers_;
+  PrimeSieveWorker* workers_;
+
+  pthread_mutex_t lock_;  // Guards everything below.
+  pthread_cond_t segment_ready_;
+  pthread_cond_t window_moved_;
+  uint64_t next_unassigned_;  // The first segment not given to a worker.
+  uint64_t next_to_read_;  // The segment at the front of the window.
+  int stopping_;
+  double start_seconds_;
+  int window_;
+  uint64_t* window_words_;
+  int* window_bits_;  // The bits in each slot's segment, 0 until it is sieved.
+
+  // Only used by the thread reading the primes.
+  int reading_segment_;
+  int next_bit_;
+} ParallelPrimeSieve;
+
+// Prepares the sieve to produce primes starting with the smallest prime which
+// is at least start, using num_threads threads. A num_threads of 0 or less
+// uses one thread per online processor. If sizes is NULL, the sizes are
+// detected with PrimeSieveDetectSizes.
+void ParallelPrimeSieveInit(uint64_t start, int num_threads,
+                            const PrimeSieveSizes* sizes,
+                            ParallelPrimeSieve* this);
+
+// Stops the threads and releases the memory held by the sieve.
+void ParallelPrimeSieveFree(ParallelPrimeSieve* this);
+
+// Provides the next prime in increasing order. Returns 0 once every prime
+// below 2^64 has been produced. Must only be called from one thread.
+uint64_t ParallelPrimeSieveNext(ParallelPrimeSieve* this);
+
+// Writes the number of segments and primes each thread has sieved so far,
+// along with its rate in primes per second of sieving.
+void ParallelPrimeSieveReport(ParallelPrimeSieve* this, FILE* out);
+
+#endif
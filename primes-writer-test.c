@@ -0,0 +1,170 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "primes-writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FILE "primes-writer-test.tmp"
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+// Replaces the test file with the given contents.
+void WriteFile(const char* contents) {
+  FILE* out = fopen(TEST_FILE, "w");
+  Check(out != NULL, "the test file can be created");
+  fputs(contents, out);
+  fclose(out);
+}
+
+// Reads the whole test file into a string which the caller frees.
+char* ReadFile() {
+  FILE* in = fopen(TEST_FILE, "r");
+  Check(in != NULL, "the test file can be read");
+  fseek(in, 0, SEEK_END);
+  long size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  char* contents = malloc(size + 1);
+  Check(fread(contents, 1, size, in) == (size_t)size, "read the test file");
+  contents[size] = '\0';
+  fclose(in);
+  return contents;
+}
+
+void TestAppend() {
+  remove(TEST_FILE);
+  PrimesWriter writer;
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  PrimesWriterAppend("0100_02 # int value: 2\n", 23, &writer);
+  PrimesWriterAppend("0100_03 # int value: 3\n", 23, &writer);
+  char* contents = ReadFile();
+  Check(strcmp(contents, "") == 0, "records wait in the buffer");
+  free(contents);
+  PrimesWriterClose(&writer);
+
+  contents = ReadFile();
+  Check(strcmp(contents,
+               "0100_02 # int value: 2\n"
+               "0100_03 # int value: 3\n"
+               "# checkpoint after 2 primes\n") == 0,
+        "closing writes the records and a checkpoint");
+  free(contents);
+
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  PrimesWriterAppend("0100_05 # int value: 5\n", 23, &writer);
+  PrimesWriterFlush(&writer);
+  contents = ReadFile();
+  Check(strstr(contents, "0100_03 # int value: 3\n# checkpoint after 2 "
+                         "primes\n0100_05 # int value: 5\n") != NULL,
+        "reopening appends after the existing records");
+  free(contents);
+  PrimesWriterClose(&writer);
+}
+
+void TestPoll() {
+  remove(TEST_FILE);
+  PrimesWriter writer;
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  PrimesWriterAppend("0100_02 # int value: 2\n", 23, &writer);
+  PrimesWriterPoll(&writer);
+  char* contents = ReadFile();
+  Check(strcmp(contents, "") == 0, "polling early leaves records buffered");
+  free(contents);
+
+  // As if a search had been working on the next prime for a while.
+  writer.next_flush_ = 0;
+  PrimesWriterPoll(&writer);
+  contents = ReadFile();
+  Check(strcmp(contents, "0100_02 # int value: 2\n") == 0,
+        "polling writes out records which have waited");
+  free(contents);
+  PrimesWriterClose(&writer);
+}
+
+void TestFullBuffer() {
+  remove(TEST_FILE);
+  PrimesWriter writer;
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  char record[] = "0400_FBFFFFFF # int value: 4294967291\n";
+  int length = strlen(record);
+  int num_records = PRIMES_WRITER_BUFFER_BYTES / length + 1;
+  int i;
+  for (i = 0; i < num_records; i++) {
+    PrimesWriterAppend(record, length, &writer);
+  }
+  char* contents = ReadFile();
+  Check(strlen(contents) == (size_t)(num_records - 1) * length,
+        "a full buffer is written out");
+  free(contents);
+  PrimesWriterClose(&writer);
+}
+
+void TestTornLine() {
+  WriteFile("0100_02 # int value: 2\n0100_03 # int va");
+  PrimesWriter writer;
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  char* contents = ReadFile();
+  Check(strcmp(contents, "0100_02 # int value: 2\n") == 0,
+        "a partial line is cut off");
+  free(contents);
+  PrimesWriterAppend("0100_03 # int value: 3\n", 23, &writer);
+  PrimesWriterClose(&writer);
+  contents = ReadFile();
+  Check(strcmp(contents,
+               "0100_02 # int value: 2\n"
+               "0100_03 # int value: 3\n"
+               "# checkpoint after 1 primes\n") == 0,
+        "records follow the last whole line");
+  free(contents);
+
+  WriteFile("0100_0");
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  contents = ReadFile();
+  Check(strcmp(contents, "") == 0, "a file without a whole line is emptied");
+  free(contents);
+  PrimesWriterClose(&writer);
+
+  // A partial line longer than the chunks read from the end of the file.
+  char* long_line = malloc(10001);
+  memset(long_line, 'F', 10000);
+  long_line[10000] = '\0';
+  FILE* out = fopen(TEST_FILE, "w");
+  fputs("0100_02 # int value: 2\n0100_", out);
+  fputs(long_line, out);
+  fclose(out);
+  free(long_line);
+  PrimesWriterOpen(TEST_FILE, 0, &writer);
+  contents = ReadFile();
+  Check(strcmp(contents, "0100_02 # int value: 2\n") == 0,
+        "a long partial line is cut off");
+  free(contents);
+  PrimesWriterClose(&writer);
+}
+
+int main() {
+  TestAppend();
+  TestPoll();
+  TestFullBuffer();
+  TestTornLine();
+  remove(TEST_FILE);
+  printf("All tests passed\n");
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Needed for clock_gettime, fsync, ftruncate and pread under -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include "primes-writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// How much of the end of the file to read at a time while looking for its
+// last newline.
+#define TAIL_CHUNK_BYTES 4096
+
+static void ErrorOut(char* message) {
+  fprintf(stderr, "%s\n", message);
+  exit(1);
+}
+
+static double Seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Cuts the file off just after its last newline. The records which follow
+// it were never finished, and dropping a whole record is harmless since the
+// search finds it again.
+static void TruncateTornLine(int fd) {
+  off_t end = lseek(fd, 0, SEEK_END);
+  if (end < 0) {
+    ErrorOut("Unable to find the end of the primes file.");
+  }
+  char chunk[TAIL_CHUNK_BYTES];
+  off_t keep = end;
+  while (keep > 0) {
+    off_t start = keep > TAIL_CHUNK_BYTES ? keep - TAIL_CHUNK_BYTES : 0;
+    ssize_t length = pread(fd, chunk, keep - start, start);
+    if (length != keep - start) {
+      ErrorOut("Unable to read the end of the primes file.");
+    }
+    ssize_t i;
+    for (i = length - 1; i >= 0 && chunk[i] != '\n'; i--) {
+    }
+    if (i >= 0) {
+      keep = start + i + 1;
+      break;
+    }
+    keep = start;
+  }
+  if (keep < end) {
+    fprintf(stderr, "Dropping %lld bytes of a partial line at the end of "
+            "the primes file.\n", (long long)(end - keep));
+    if (ftruncate(fd, keep) != 0) {
+      ErrorOut("Unable to truncate the primes file.");
+    }
+  }
+}
+
+void PrimesWriterOpen(const char* filename, int checkpoint_seconds,
+                      PrimesWriter* this) {
+  this->fd_ = open(filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (this->fd_ < 0) {
+    fprintf(stderr, "Unable to open %s for appending.\n", filename);
+    exit(1);
+  }
+  TruncateTornLine(this->fd_);
+
+  this->buffer_ = malloc(PRIMES_WRITER_BUFFER_BYTES);
+  if (this->buffer_ == NULL) {
+    ErrorOut("Unable to allocate space for the primes file buffer.");
+  }
+  this->used_ = 0;
+  this->checkpoint_seconds_ = checkpoint_seconds > 0
+                                  ? checkpoint_seconds
+                                  : PRIMES_WRITER_CHECKPOINT_SECONDS;
+  double now = Seconds();
+  this->next_flush_ = now + PRIMES_WRITER_FLUSH_SECONDS;
+  this->next_checkpoint_ = now + this->checkpoint_seconds_;
+  this->records_ = 0;
+}
+
+void PrimesWriterFlush(PrimesWriter* this) {
+  int written = 0;
+  while (written < this->used_) {
+    ssize_t length = write(this->fd_, this->buffer_ + written,
+                           this->used_ - written);
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length <= 0) {
+      ErrorOut("Unable to write to the primes file.");
+    }
+    written += length;
+  }
+  this->used_ = 0;
+  this->next_flush_ = Seconds() + PRIMES_WRITER_FLUSH_SECONDS;
+}
+
+void PrimesWriterPoll(PrimesWriter* this) {
+  if (this->used_ > 0 && Seconds() >= this->next_flush_) {
+    PrimesWriterFlush(this);
+  }
+}
+
+void PrimesWriterCheckpoint(PrimesWriter* this) {
+  char record[64];
+  int length = snprintf(record, sizeof(record),
+                        "# checkpoint after %llu primes\n",
+                        (unsigned long long)this->records_);
+  if (this->used_ + length > PRIMES_WRITER_BUFFER_BYTES) {
+    PrimesWriterFlush(this);
+  }
+  memcpy(this->buffer_ + this->used_, record, length);
+  this->used_ += length;
+  PrimesWriterFlush(this);
+  if (fsync(this->fd_) != 0) {
+    ErrorOut("Unable to sync the primes file to disk.");
+  }
+  this->next_checkpoint_ = Seconds() + this->checkpoint_seconds_;
+}
+
+void PrimesWriterAppend(const char* record, int length, PrimesWriter* this) {
+  if (length > PRIMES_WRITER_BUFFER_BYTES) {
+    ErrorOut("A record is larger than the primes file buffer.");
+  }
+  if (this->used_ + length > PRIMES_WRITER_BUFFER_BYTES) {
+    PrimesWriterFlush(this);
+  }
+  memcpy(this->buffer_ + this->used_, record, length);
+  this->used_ += length;
+  this->records_++;
+
+  double now = Seconds();
+  if (now >= this->next_checkpoint_) {
+    PrimesWriterCheckpoint(this);
+  } else if (now >= this->next_flush_) {
+    PrimesWriterFlush(this);
+  }
+}
+
+void PrimesWriterClose(PrimesWriter* this) {
+  PrimesWriterCheckpoint(this);
+  close(this->fd_);
+  free(this->buffer_);
+  this->fd_ = -1;
+  this->buffer_ = NULL;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRIMES_WRITER_H
+#define PRIMES_WRITER_H
+
+#include <stdint.h>
+
+// How many bytes of records to gather before writing them out.
+#define PRIMES_WRITER_BUFFER_BYTES (1 << 20)
+
+// How long records gather in the buffer before being written out, so a slow
+// search still shows up in the file promptly.
+#define PRIMES_WRITER_FLUSH_SECONDS 1
+
+// How often the file is synced to disk by default.
+#define PRIMES_WRITER_CHECKPOINT_SECONDS 60
+
+// Appends records to the primes file in large batches instead of one write
+// per prime.
+//
+// Records are gathered in a buffer which is written out whole once it fills
+// or once PRIMES_WRITER_FLUSH_SECONDS have passed since the last write. That
+// is only noticed when a record is appended or PrimesWriterPoll is called,
+// so a search which can go a long time between primes should call
+// PrimesWriterPoll while it works. Then a process killed with kill -9 loses
+// at most about the last second of records, which the next run finds again.
+// Every checkpoint_seconds_ a "# checkpoint" comment line is added and the
+// file is synced, which bounds what a power failure can lose. Only whole
+// lines are ever written, and opening the file cuts off anything after its
+// last newline, so a torn line left by a crash mid-write never reaches the
+// parsers.
+//
+// A PrimesWriter must be set up with PrimesWriterOpen and released with
+// PrimesWriterClose.
+typedef struct {
+  int fd_;
+  char* buffer_;
+  int used_;  // The bytes of records waiting in buffer_.
+  int checkpoint_seconds_;
+  double next_flush_;  // When to write out the buffer, in seconds.
+  double next_checkpoint_;
+  uint64_t records_;  // The records appended since the file was opened.
+} PrimesWriter;
+
+// Opens the file for appending, creating it if needed, after cutting off any
+// partial line at its end. A checkpoint_seconds of 0 or less uses
+// PRIMES_WRITER_CHECKPOINT_SECONDS.
+void PrimesWriterOpen(const char* filename, int checkpoint_seconds,
+                      PrimesWriter* this);
+
+// Adds a record of length bytes, which must be one or more whole lines.
+void PrimesWriterAppend(const char* record, int length, PrimesWriter* this);
+
+// Writes out the records waiting in the buffer.
+void PrimesWriterFlush(PrimesWriter* this);
+
+// Writes out the records waiting in the buffer if PRIMES_WRITER_FLUSH_SECONDS
+// have passed since the last write. This is cheap enough to call often from a
+// long search.
+void PrimesWriterPoll(PrimesWriter* this);
+
+// Adds a checkpoint line, writes out the buffer and syncs the file to disk.
+void PrimesWriterCheckpoint(PrimesWriter* this);
+
+// Checkpoints the file and closes it.
+void PrimesWriterClose(PrimesWriter* this);
+
+#endif
@@ -19,6 +19,8 @@
 // division to prove that the number is prime. If the provided time limit
 // is exceeded, the number is reported as probably prime.
 
+#include "large-u-int.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,13 +73,38 @@ void FillCandidateRandomlyByBits(mpz_t candidate, int num_bits) {
   mpz_init_set_str(candidate, buffer, 2);
 }
 
-// Reports whether a number is certainly not prime (0), certainly prime (2) or
-// probably prime (1) after spending around timeout minutes trying to find a
-// divisor. The timeout is a loose limit and doesn't start until the initial
-// probable prime check is complete. The timeout is used just during the spot
-// check trial divison.
+// Copies the value of a GMP integer in to a newly initialized LargeUInt.
+void InitLargeUIntFromMpz(mpz_t value, LargeUInt* this) {
+  // mpz_sizeinbase only bounds the size, and zero exports no bytes at all, so
+  // the count mpz_export gives is what is used.
+  size_t max_bytes = (mpz_sizeinbase(value, 2) + 7) / 8;
+  unsigned char* bytes = malloc(max_bytes);
+  if (bytes == NULL) {
+    fprintf(stderr, "Unable to allocate space to copy the candidate.\n");
+    exit(1);
+  }
+  size_t count = 0;
+  mpz_export(bytes, &count, -1, 1, 0, 0, value);
+  LargeUIntInit(count, this);
+  for (size_t i = 0; i < count; i++) {
+    LargeUIntSetByte(bytes[i], i, this);
+  }
+  free(bytes);
+}
+
+// Reports whether a number is certainly not prime (0), probably prime (1) or
+// certainly prime (2). The Baillie-PSW screen only ever gives 0 or 1. A
+// candidate which passes it then has around timeout minutes of trial
+// division, which gives 0 if a divisor turns up, 2 if every divisor up to the
+// square root is tried and 1 if time runs out first. The timeout is a loose
+// limit and doesn't start until the screen is complete.
 int IsPrime(mpz_t candidate, int timeout) {
-  int candidate_status = mpz_probab_prime_p(candidate, 100);
+  // A single Baillie-PSW test screens the candidate, which is cheaper than
+  // many rounds of Miller-Rabin and has no known counterexample.
+  LargeUInt large_candidate;
+  InitLargeUIntFromMpz(candidate, &large_candidate);
+  int candidate_status = LargeUIntIsBailliePSWPrime(&large_candidate);
+  LargeUIntFree(&large_candidate);
   if (candidate_status == 1) {
     printf("Starting prime verification (%i minutes)\n", timeout);
     mpz_t remainder;
@@ -15,6 +15,7 @@
  */
 
 #include "large-u-int.h"
+#include "nearby-prime.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,74 +31,6 @@ void FillCandidateRandomly(int num_bytes, LargeUInt* candidate) {
   }
 }
 
-void FindNearbyPrime(LargeUInt* candidate) {
-  if (LargeUIntGetByte(0, candidate) % 2 == 0) {
-    LargeUIntIncrement(candidate);
-  }
-
-  LargeUInt quotient;
-  LargeUInt remainder;
-
-  // Establish the limit of the highest divisor we need to try.
-  LargeUInt max_divisor;
-  LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-
-  // To report progress, track when we have tried each 2% of the possible
-  // divisors.
-  LargeUInt one_fiftieth_max;
-  LargeUInt next_reporting_milestone;
-  LargeUInt fifty;
-  LargeUIntInit(1, &fifty);
-  LargeUIntSetByte(50, 0, &fifty);
-  LargeUIntDivide(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
-  LargeUIntClone(&one_fiftieth_max, &next_reporting_milestone);
-
-  printf("Starting with possible prime ");
-  LargeUIntBase10Print(candidate, stdout);
-  printf("\nMaximum divisor: ");
-  LargeUIntPrint(&max_divisor, stdout);
-  printf("\nProgress: 0|-------20|-------40|-------60|-------80|------100|");
-  printf("\n           x");
-  fflush(stdout);
-
-  // Try divisors starting with the smallest possible: 3.
-  LargeUInt divisor;
-  LargeUIntInit(1, &divisor);
-  LargeUIntSetByte(3, 0, &divisor);
-  while (LargeUIntCompare(&divisor, &max_divisor) >= 0) {
-    LargeUIntMod(candidate, &divisor, &remainder);
-    if (LargeUIntNumBytes(&remainder) == 0) {
-      LargeUIntAddByte(2, candidate);
-      LargeUIntInit(1, &divisor);
-      LargeUIntSetByte(3, 0, &divisor);
-
-      printf("\nTrying a new possible prime ");
-      LargeUIntBase10Print(candidate, stdout);
-      printf("\nMaximum divisor: ");
-      LargeUIntPrint(&max_divisor, stdout);
-      printf("\nProgress: 0|-------20|-------40|-------60|-------80|");
-      printf("------100|\n           x");
-      fflush(stdout);
-
-      // New candidate so find a new cap for divisors.
-      LargeUIntApproximateSquareRoot(candidate, &max_divisor);
-
-      // Report the new candidate and reset our progress reporting.
-      LargeUIntDivide(&max_divisor, &fifty, &one_fiftieth_max, &remainder);
-      LargeUIntClone(&one_fiftieth_max, &next_reporting_milestone);
-    } else {
-      LargeUIntAddByte(2, &divisor);
-      if (LargeUIntCompare(&divisor, &next_reporting_milestone) < 1) {
-        printf("x");
-        fflush(stdout);
-        LargeUIntAdd(&one_fiftieth_max, &next_reporting_milestone);
-      }
-    }
-  }
-
-  // We ran out of divisors so the value stored in candidate is prime.
-}
-
 void PrintPrime(LargeUInt* prime, FILE* out) {
   LargeUIntPrint(prime, out);
   fprintf(out, " # int value: ");
@@ -105,19 +38,37 @@ void PrintPrime(LargeUInt* prime, FILE* out) {
   fprintf(out, "\n");
 }
 
-void GenerateRandomPrime(int num_bytes) {
+void GenerateRandomPrime(int num_bytes, int use_prp) {
   LargeUInt candidate;
   FillCandidateRandomly(num_bytes, &candidate);
-  FindNearbyPrime(&candidate);
-  printf("\nPrime:\n");
+  if (use_prp) {
+    FindNearbyProbablePrime(&candidate);
+    printf("\nProbable prime:\n");
+  } else {
+    ProgressBar progress_bar;
+    ProgressBarInit(&progress_bar);
+    FindNearbyPrime(&candidate, ProgressBarShow, &progress_bar);
+    ProgressBarFree(&progress_bar);
+    printf("\nPrime:\n");
+  }
   PrintPrime(&candidate, stdout);
   printf("\n");
+  LargeUIntFree(&candidate);
 }
 
 int main(int argc, char *argv[]) {
+  int use_prp = 0;
+  if (argc > 1 && strcmp(argv[1], "--prp") == 0) {
+    use_prp = 1;
+    argc--;
+    argv++;
+  }
   if (argc < 2) {
-    printf("Usage: %s <number of bytes in the desired prime>\n", argv[0]);
+    printf("Usage: %s [--prp] <number of bytes in the desired prime>\n",
+           argv[0]);
     printf("For example %s 8\n", argv[0]);
+    printf("With --prp the Miller-Rabin test is used instead of trial "
+           "division.\n");
     return 1;
   }
   int num_bytes = atoi(argv[1]);
@@ -127,7 +78,7 @@ int main(int argc, char *argv[]) {
     return 1;
   }
   srand(time(0));
-  GenerateRandomPrime(num_bytes);
+  GenerateRandomPrime(num_bytes, use_prp);
   return 0;
 }
 
@@ -14,208 +14,296 @@
  * limitations under the License.
  */
 
+// Needed for clock_gettime under -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include "prime-record.h"
+#include "prime-sieve.h"
+#include "primes-writer.h"
+#include "u-int-prime.h"
+
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
 #include<stdint.h>
+#include<time.h>
 
-const char HEX_BYTES[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
-                          'A', 'B', 'C', 'D', 'E', 'F'};
-
-void BigIntPrint(uint_fast64_t x, FILE *out) {
-  int num_bytes;
-  if (x <= 0xFF) {
-    num_bytes = 1;
-  } else if (x <= 0xFFFF) {
-    num_bytes = 2;
-  } else if (x <= 0xFFFFFF) {
-    num_bytes = 3;
-  } else if (x <= 0xFFFFFFFF) {
-    num_bytes = 4;
-  } else {
-    printf("reached size limit");
-    exit(1);
-  }
+// How often, in seconds, to report each thread's throughput.
+#define REPORT_INTERVAL 60
 
-  fprintf(out, "0%c00_", HEX_BYTES[num_bytes]);
-  uint_fast64_t x_copy = x;
-  while (x > 0) {
-    fprintf(out, "%c%c", HEX_BYTES[x >> 4 & 0x0F], HEX_BYTES[x & 0x0F]);
-    x >>= 8;
-  }
-  fprintf(out, " # int value: %llu\n", x_copy);
-}
+// The ways of finding the primes after the highest one found so far.
+typedef enum {
+  // Sieves every value, which is fastest when every prime is wanted.
+  ENGINE_SIEVE,
+  // Tests each candidate on its own with Miller-Rabin, which needs no table
+  // of sieving primes and so starts at once anywhere below 2^64.
+  ENGINE_MILLER_RABIN
+} Engine;
 
-int HexCharToNibble(char hex_char) {
-  if (hex_char >= '0' && hex_char <= '9') {
-    return hex_char - '0';
-  } else if (hex_char >= 'A' && hex_char <= 'F') {
-    return hex_char + 10 - 'A';
-  } else {
-    return -1;
-  }
-}
-
-uint_fast64_t FindNearbyPrime(uint_fast64_t candidate) {
-  if (candidate % 2 == 0) {
-    candidate++;
-  }
-
-  uint_fast64_t max_divisor = candidate / 2;
-  for (uint_fast64_t divisor = 3; divisor <= max_divisor;) {
-    if (candidate % divisor == 0) {
-      candidate += 2;
-      divisor = 3;
-      max_divisor = candidate / 2;
-    } else {
-      max_divisor = candidate / divisor;
-      divisor += 2;
-    }
-  }
+// The number of values sieved for each size tried by --benchmark.
+#define BENCHMARK_SPAN ((uint_fast64_t)1 << 32)
 
-  // We ran out of divisors so candidate is prime.
-  return candidate;
+void BigIntPrint(unsigned __int128 x, FILE *out) {
+  char record[PRIME_RECORD_BYTES];
+  FormatPrime(x, record);
+  fputs(record, out);
 }
 
-uint_fast64_t LoadNextPrime(FILE* primes) {
+unsigned __int128 FindHighestPrime(char* filename) {
+  FILE* primes = fopen(filename, "r");
   if (primes == NULL) {
     return 0;
   }
 
-  int current = fgetc(primes);
-  int state = 0;
-  int num_bytes = 0;
-  int byte_index = 0;
-  int current_value = -1;
-  uint_fast64_t result = 0;
-  int shift = 0;
-  while (1) {
-    if (feof(primes)) {
-      break;
-    }
+  unsigned __int128 next_prime = LoadNextPrime(primes);
+  unsigned __int128 result = 0;
+  while (next_prime != 0) {
+    result = next_prime;
+    next_prime = LoadNextPrime(primes);
+  }
+  fclose(primes);
+  return result;
+}
 
-    if (current == '#') {
-      state = 10;
-    }
+// Writes a newly found prime to the primes file. The engines report their
+// progress every REPORT_INTERVAL seconds instead of printing each prime,
+// which would hold the sieve to the speed of the terminal.
+void RecordPrime(unsigned __int128 prime, PrimesWriter* primes) {
+  char record[PRIME_RECORD_BYTES];
+  int length = FormatPrime(prime, record);
+  PrimesWriterAppend(record, length, primes);
+}
 
-    if (state == 10) {
-      if (current == '\n') {
-        state = 0;
-      }
-      current = fgetc(primes);
-      continue;
+// Finds each prime after candidate by testing the candidates one at a time.
+void TestCandidates(uint_fast64_t candidate, PrimesWriter* primes) {
+  time_t start_time = time(NULL);
+  time_t next_report = start_time + REPORT_INTERVAL;
+  uint_fast64_t primes_found = 0;
+  uint_fast64_t prime;
+  while (candidate < UINT64_MAX &&
+         (prime = UIntNextPrime(candidate + 1)) != 0) {
+    RecordPrime(prime, primes);
+    primes_found++;
+    candidate = prime;
+    if (time(NULL) >= next_report) {
+      printf("Tested candidates up to %llu, %.0f primes per second.\n",
+             (unsigned long long)candidate,
+             (double)primes_found / (time(NULL) - start_time));
+      next_report += REPORT_INTERVAL;
     }
+  }
+}
 
-    current_value = HexCharToNibble(current);
-    if (current_value == -1) {
-      // Skip over non hex characters.
-      current = fgetc(primes);
-      continue;
-    }
+// Prints how many primes have been sieved and recorded per second overall.
+void ReportSieveRate(uint_fast64_t candidate, uint_fast64_t primes_found,
+                     time_t start_time) {
+  time_t elapsed = time(NULL) - start_time;
+  printf("Recorded primes up to %llu, %.0f primes per second.\n",
+         (unsigned long long)candidate,
+         elapsed > 0 ? (double)primes_found / elapsed : 0);
+}
 
-    switch (state) {
-      // First char of 8 in the num_bytes.
-      case 0:
-        num_bytes = current_value << 4;
-        state = 1;
-        break;
-      case 1:
-        num_bytes += current_value;
-        state = 2;
-        break;
-      case 2:
-        num_bytes += current_value << 12;
-        state = 3;
-        break;
-      case 3:
-        num_bytes += current_value << 8;
-        state = 8;
-        break;
-      case 4:
-        num_bytes += current_value << 20;
-        state = 5;
-        break;
-      case 5:
-        num_bytes += current_value << 16;
-        state = 6;
-        break;
-      case 6:
-        num_bytes += current_value << 28;
-        state = 7;
-        break;
-      case 7:
-        num_bytes += current_value << 24;
-        state = 8;  // Reached the end of num_bytes;
-        result = 0;
-        byte_index = 0;
-        break;
-      case 8:
-        result += ((current_value << 4) << shift);
-        state = 9;
-        break;
-      case 9:
-        result += (current_value << shift);
-        byte_index++;
-        shift += 8;
-        if (byte_index < num_bytes) {
-          state = 8;
-        } else {
-          return result;
-        }
-        break;
-      case 10:
-        break;
+// Streams every prime after candidate out of the sieve.
+void SieveCandidates(uint_fast64_t candidate, int num_threads,
+                     const PrimeSieveSizes* sizes, PrimesWriter* primes) {
+  printf("Sieving with %d byte segments and %d byte bucket blocks.\n",
+         sizes->segment_bytes_, sizes->bucket_bytes_);
+  ParallelPrimeSieve sieve;
+  ParallelPrimeSieveInit(candidate + 1, num_threads, sizes, &sieve);
+  // The threads only time their own sieving, so the overall rate, which
+  // includes writing the primes file, is reported alongside them.
+  time_t start_time = time(NULL);
+  time_t next_report = start_time + REPORT_INTERVAL;
+  uint_fast64_t primes_found = 0;
+  uint_fast64_t prime;
+  while ((prime = ParallelPrimeSieveNext(&sieve)) != 0) {
+    RecordPrime(prime, primes);
+    primes_found++;
+    candidate = prime;
+    if (time(NULL) >= next_report) {
+      ReportSieveRate(candidate, primes_found, start_time);
+      ParallelPrimeSieveReport(&sieve, stdout);
+      next_report += REPORT_INTERVAL;
     }
-    current = fgetc(primes);
   }
-  return 0;
+  ReportSieveRate(candidate, primes_found, start_time);
+  ParallelPrimeSieveReport(&sieve, stdout);
+  ParallelPrimeSieveFree(&sieve);
 }
 
-uint_fast64_t FindHighestPrime(char* filename) {
-  FILE* primes = fopen(filename, "r");
-  if (primes == NULL) {
-    return 0;
-  }
-
-  uint_fast64_t next_prime = LoadNextPrime(primes);
-  uint_fast64_t result;
-  while (next_prime != 0) {
-    result = next_prime;
-    next_prime = LoadNextPrime(primes);
+// Finds each prime after candidate up to 2^128 with the 128 bit sieve, which
+// takes over once the 64 bit range is done.
+void SieveWideCandidates(unsigned __int128 candidate, PrimesWriter* primes) {
+  printf("Sieving past 2^64 and testing what is left with Miller-Rabin.\n");
+  UInt128Sieve sieve;
+  UInt128SieveInit(candidate + 1, &sieve);
+  time_t start_time = time(NULL);
+  time_t next_report = start_time + REPORT_INTERVAL;
+  uint_fast64_t primes_found = 0;
+  unsigned __int128 prime;
+  while ((prime = UInt128SieveNext(&sieve)) != 0) {
+    RecordPrime(prime, primes);
+    primes_found++;
+    if (time(NULL) >= next_report) {
+      char digits[40];
+      FormatBase10(prime, digits);
+      printf("Sieved up to %s, %.0f primes per second.\n", digits,
+             (double)primes_found / (time(NULL) - start_time));
+      next_report += REPORT_INTERVAL;
+    }
   }
-  fclose(primes);
-  return result;
+  UInt128SieveFree(&sieve);
 }
 
-void AppendPrime(char* filename, uint_fast64_t prime) {
-  FILE* primes = fopen(filename, "a");
-  BigIntPrint(prime, primes);
-  fclose(primes);
-}
+void GeneratePrimes(char* filename, Engine engine, int num_threads,
+                    const PrimeSieveSizes* sizes, int checkpoint_seconds) {
+  // Opening the writer first cuts off any line a crash left half written.
+  PrimesWriter primes;
+  PrimesWriterOpen(filename, checkpoint_seconds, &primes);
 
-void GeneratePrimes(char* filename) {
   // Start by finding the higest prime that we have so far.
   printf("Looking for highest prime already found.\n");
-  uint_fast64_t candidate = FindHighestPrime(filename);
+  unsigned __int128 candidate = FindHighestPrime(filename);
   printf("Starting from highest prime found so far: ");
   BigIntPrint(candidate, stdout);
 
-  uint_fast64_t first_candidate = candidate;
-  uint_fast64_t prime;
-
-  // Add two to start trying new primes.
-  candidate += 2;
+  // The 64 bit engines only return once every prime below 2^64 is found.
+  if (candidate < UINT64_MAX) {
+    if (engine == ENGINE_MILLER_RABIN) {
+      TestCandidates(candidate, &primes);
+    } else {
+      SieveCandidates(candidate, num_threads, sizes, &primes);
+    }
+    candidate = UINT64_MAX;
+  }
+  SieveWideCandidates(candidate, &primes);
+  PrimesWriterClose(&primes);
+  printf("Found every prime below 2^128. "
+         "large-u-int-resumable-prime-finder continues from here.\n");
+}
 
-  while(candidate > first_candidate) {
-    prime = FindNearbyPrime(candidate);
-    AppendPrime(filename, prime);
-    printf("Found prime: ");
-    BigIntPrint(prime, stdout);
-    candidate = prime + 2;
+// Times sieving BENCHMARK_SPAN values from start with the given sizes.
+double TimeSieve(uint_fast64_t start, int num_threads,
+                 const PrimeSieveSizes* sizes) {
+  struct timespec before, after;
+  clock_gettime(CLOCK_MONOTONIC, &before);
+  ParallelPrimeSieve sieve;
+  ParallelPrimeSieveInit(start, num_threads, sizes, &sieve);
+  uint_fast64_t prime = ParallelPrimeSieveNext(&sieve);
+  while (prime != 0 && prime - start < BENCHMARK_SPAN) {
+    prime = ParallelPrimeSieveNext(&sieve);
   }
+  ParallelPrimeSieveFree(&sieve);
+  clock_gettime(CLOCK_MONOTONIC, &after);
+  return after.tv_sec - before.tv_sec +
+         (after.tv_nsec - before.tv_nsec) / 1e9;
 }
 
-int main() {
-  GeneratePrimes("primes");
+// Tries each segment size and then each bucket size from where the primes
+// file leaves off, to find the sizes to pass as overrides on this machine.
+void BenchmarkSizes(char* filename, int num_threads,
+                    const PrimeSieveSizes* detected_sizes) {
+  // The sizes only matter to the 64 bit sieve, which is done once the
+  // primes file reaches the last prime below 2^64.
+  unsigned __int128 highest = FindHighestPrime(filename);
+  if (highest >= UINT64_MAX || UIntNextPrime(highest + 1) == 0) {
+    fprintf(stderr, "The primes file has passed the 64 bit sieve, so there "
+            "are no sizes to benchmark.\n");
+    exit(1);
+  }
+  uint_fast64_t start = highest + 1;
+  PrimeSieveSizes sizes = *detected_sizes;
+  PrimeSieveSizes best_sizes = sizes;
+  double best_seconds = -1;
+  int size;
+  for (size = 8192; size <= (1 << 20); size *= 2) {
+    sizes.segment_bytes_ = size;
+    double seconds = TimeSieve(start, num_threads, &sizes);
+    printf("--segment-bytes %d: %.2f seconds\n", size, seconds);
+    if (best_seconds < 0 || seconds < best_seconds) {
+      best_seconds = seconds;
+      best_sizes = sizes;
+    }
+  }
+  sizes = best_sizes;
+  for (size = 1024; size <= (1 << 16); size *= 2) {
+    sizes.bucket_bytes_ = size;
+    double seconds = TimeSieve(start, num_threads, &sizes);
+    printf("--bucket-bytes %d: %.2f seconds\n", size, seconds);
+    if (seconds < best_seconds) {
+      best_seconds = seconds;
+      best_sizes = sizes;
+    }
+  }
+  printf("Detected sizes: --segment-bytes %d --bucket-bytes %d\n",
+         detected_sizes->segment_bytes_, detected_sizes->bucket_bytes_);
+  printf("Fastest sizes: --segment-bytes %d --bucket-bytes %d\n",
+         best_sizes.segment_bytes_, best_sizes.bucket_bytes_);
 }
 
+int main(int argc, char *argv[]) {
+  // The options are:
+  //   --threads N        use N threads instead of one per processor.
+  //   --segment-bytes N  override the segment size chosen from the caches.
+  //   --bucket-bytes N   override the bucket block size chosen from the
+  //                      caches.
+  //   --benchmark        time the sizes which could be used from where the
+  //                      primes file leaves off, instead of finding primes.
+  //   --engine NAME      find the primes with "sieve", the default, or
+  //                      "miller-rabin".
+  //   --next N           print the smallest prime above N and exit, without
+  //                      touching the primes file.
+  //   --checkpoint-seconds N
+  //                      sync the primes file to disk every N seconds
+  //                      instead of every minute.
+  int num_threads = 0;
+  int benchmark = 0;
+  Engine engine = ENGINE_SIEVE;
+  int checkpoint_seconds = 0;
+  PrimeSieveSizes sizes;
+  PrimeSieveDetectSizes(&sizes);
+  int i;
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--segment-bytes") == 0 && i + 1 < argc) {
+      sizes.segment_bytes_ = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--bucket-bytes") == 0 && i + 1 < argc) {
+      sizes.bucket_bytes_ = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--benchmark") == 0) {
+      benchmark = 1;
+    } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "sieve") == 0) {
+        engine = ENGINE_SIEVE;
+      } else if (strcmp(argv[i], "miller-rabin") == 0) {
+        engine = ENGINE_MILLER_RABIN;
+      } else {
+        fprintf(stderr, "Unknown engine: %s\n", argv[i]);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "--checkpoint-seconds") == 0 &&
+               i + 1 < argc) {
+      checkpoint_seconds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--next") == 0 && i + 1 < argc) {
+      uint_fast64_t n = strtoull(argv[++i], NULL, 10);
+      uint_fast64_t prime = n < UINT64_MAX ? UIntNextPrime(n + 1) : 0;
+      if (prime == 0) {
+        printf("There is no prime above %llu below 2^64.\n",
+               (unsigned long long)n);
+      } else {
+        printf("%llu\n", (unsigned long long)prime);
+      }
+      return 0;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[i]);
+      exit(1);
+    }
+  }
+
+  if (benchmark) {
+    BenchmarkSizes("primes", num_threads, &sizes);
+  } else {
+    GeneratePrimes("primes", engine, num_threads, &sizes, checkpoint_seconds);
+  }
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "u-int-prime.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+// A simple linear congruential generator, so the tests repeat exactly.
+uint64_t NextRandom(uint64_t* state) {
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *state;
+}
+
+void TestMontgomery() {
+  uint64_t moduli[] = {3, 1000000007, 0xFFFFFFFFFFFFFFC5ULL,
+                       0xFFFFFFFFFFFFFFFFULL, (1ULL << 63) + 1};
+  uint64_t state = 1;
+  int i;
+  for (i = 0; i < 5; i++) {
+    uint64_t n = moduli[i];
+    Montgomery montgomery;
+    MontgomeryInit(n, &montgomery);
+    Check(MontgomeryOut(&montgomery, montgomery.one_) == 1, "one is one");
+    int j;
+    for (j = 0; j < 1000; j++) {
+      uint64_t a = NextRandom(&state) % n;
+      uint64_t b = NextRandom(&state) % n;
+      uint64_t product = MontgomeryOut(
+          &montgomery, MontgomeryMultiply(&montgomery,
+                                          MontgomeryIn(&montgomery, a),
+                                          MontgomeryIn(&montgomery, b)));
+      Check(product == (unsigned __int128)a * b % n,
+            "Montgomery products match");
+    }
+  }
+
+  Montgomery montgomery;
+  MontgomeryInit(1000000007, &montgomery);
+  uint64_t power = MontgomeryPower(&montgomery,
+                                   MontgomeryIn(&montgomery, 2), 1000000006);
+  Check(MontgomeryOut(&montgomery, power) == 1, "Fermat's little theorem");
+  power = MontgomeryPower(&montgomery, MontgomeryIn(&montgomery, 3), 10);
+  Check(MontgomeryOut(&montgomery, power) == 59049, "3^10");
+}
+
+void TestSmallValues() {
+  // Compare against a sieve of Eratosthenes.
+  int limit = 1000000;
+  char* composite = calloc(limit, 1);
+  composite[0] = composite[1] = 1;
+  int i;
+  for (i = 2; i * i < limit; i++) {
+    if (!composite[i]) {
+      int j;
+      for (j = i * i; j < limit; j += i) {
+        composite[j] = 1;
+      }
+    }
+  }
+  int next_prime = limit;
+  for (i = limit - 1; i >= 0; i--) {
+    Check(UIntIsPrime(i) == !composite[i], "primes below 10^6");
+    if (!composite[i]) {
+      next_prime = i;
+    }
+    if (next_prime < limit) {
+      Check(UIntNextPrime(i) == (uint64_t)next_prime,
+            "next primes below 10^6");
+    }
+  }
+  free(composite);
+}
+
+void TestLargeValues() {
+  Check(UIntIsPrime(0xFFFFFFFFFFFFFFC5ULL), "2^64 - 59 is prime");
+  Check(!UIntIsPrime(0xFFFFFFFFFFFFFFFFULL), "2^64 - 1 is not prime");
+  Check(UIntIsPrime((1ULL << 61) - 1), "2^61 - 1 is prime");
+  Check(UIntIsPrime(1000000000000000003ULL), "10^18 + 3 is prime");
+  Check(!UIntIsPrime(1000000000000000001ULL), "10^18 + 1 is not prime");
+  Check(!UIntIsPrime(4294967291ULL * 4294967279ULL),
+        "a product of two large primes");
+
+  // Strong pseudoprimes to several of the smallest bases.
+  Check(!UIntIsPrime(3215031751ULL), "a strong pseudoprime to 2, 3, 5, 7");
+  Check(!UIntIsPrime(3825123056546413051ULL),
+        "a strong pseudoprime to the primes up to 23");
+  Check(!UIntIsPrime(2152302898747ULL),
+        "a strong pseudoprime to the primes up to 11");
+  Check(!UIntIsPrime(341550071728321ULL),
+        "a strong pseudoprime to the primes up to 17");
+  Check(!UIntIsPrime(561), "a Carmichael number");
+
+  Check(UIntNextPrime(1ULL << 32) == 4294967311ULL, "the prime after 2^32");
+  Check(UIntNextPrime(1000000000000000000ULL) == 1000000000000000003ULL,
+        "the prime after 10^18");
+  Check(UIntNextPrime(0xFFFFFFFFFFFFFFC5ULL) == 0xFFFFFFFFFFFFFFC5ULL,
+        "the largest prime below 2^64");
+  Check(UIntNextPrime(0xFFFFFFFFFFFFFFC6ULL) == 0, "no prime after it");
+  Check(UIntNextPrime(0xFFFFFFFFFFFFFFFFULL) == 0, "no prime at 2^64 - 1");
+}
+
+// Builds a 128 bit value from its two halves.
+unsigned __int128 Wide(uint64_t high, uint64_t low) {
+  return (unsigned __int128)high << 64 | low;
+}
+
+// Multiplies modulo n by doubling and adding, which is slow but needs no
+// more than 128 bits.
+unsigned __int128 SlowMultiplyMod(unsigned __int128 a, unsigned __int128 b,
+                                  unsigned __int128 n) {
+  unsigned __int128 result = 0;
+  int i;
+  for (i = 127; i >= 0; i--) {
+    result = result >= n - result ? result - (n - result) : 2 * result;
+    if (b >> i & 1) {
+      result = result >= n - a ? result - (n - a) : result + a;
+    }
+  }
+  return result;
+}
+
+void TestMontgomery128() {
+  unsigned __int128 moduli[] = {
+      3, 1000000007, Wide(1, 13), Wide(0x7FFFFFFFFFFFFFFFULL, ~0ULL),
+      Wide(~0ULL, ~0ULL), Wide(~0ULL, 0xFFFFFFFFFFFFFF61ULL)};
+  uint64_t state = 2;
+  int i;
+  for (i = 0; i < 6; i++) {
+    unsigned __int128 n = moduli[i];
+    Montgomery128 montgomery;
+    Montgomery128Init(n, &montgomery);
+    Check(Montgomery128Out(&montgomery, montgomery.one_) == 1, "one is one");
+    int j;
+    for (j = 0; j < 1000; j++) {
+      unsigned __int128 a = Wide(NextRandom(&state), NextRandom(&state)) % n;
+      unsigned __int128 b = Wide(NextRandom(&state), NextRandom(&state)) % n;
+      unsigned __int128 product = Montgomery128Out(
+          &montgomery,
+          Montgomery128Multiply(&montgomery, Montgomery128In(&montgomery, a),
+                                Montgomery128In(&montgomery, b)));
+      Check(product == SlowMultiplyMod(a, b, n),
+            "wide Montgomery products match");
+    }
+  }
+
+  // 2^127 - 1 is prime, so 3^(2^127 - 2) is 1.
+  unsigned __int128 n = Wide(0x7FFFFFFFFFFFFFFFULL, ~0ULL);
+  Montgomery128 montgomery;
+  Montgomery128Init(n, &montgomery);
+  unsigned __int128 power = Montgomery128Power(
+      &montgomery, Montgomery128In(&montgomery, 3), n - 1);
+  Check(Montgomery128Out(&montgomery, power) == 1,
+        "Fermat's little theorem for 2^127 - 1");
+}
+
+void TestWideValues() {
+  Check(UInt128IsPrime(Wide(1, 13)), "2^64 + 13 is prime");
+  Check(!UInt128IsPrime(Wide(1, 1)), "2^64 + 1 is not prime");
+  Check(UInt128IsPrime(Wide(0x1FFFFFFULL, ~0ULL)), "2^89 - 1 is prime");
+  Check(UInt128IsPrime(Wide(0x7FFFFFFFFFFFFFFFULL, ~0ULL)),
+        "2^127 - 1 is prime");
+  Check(UInt128IsPrime(Wide(~0ULL, 0xFFFFFFFFFFFFFF61ULL)),
+        "2^128 - 159 is prime");
+  Check(!UInt128IsPrime(Wide(~0ULL, ~0ULL)), "2^128 - 1 is not prime");
+  unsigned __int128 largest = 0xFFFFFFFFFFFFFFC5ULL;
+  Check(!UInt128IsPrime(largest * largest),
+        "the square of the largest 64 bit prime");
+  Check(!UInt128IsPrime((unsigned __int128)4294967291ULL * 4294967279ULL *
+                        4294967231ULL),
+        "a product of three large primes");
+
+  // The smallest strong pseudoprimes to the first 12 and 13 primes.
+  Check(!UInt128IsPrime(Wide(0x437AULL, 0xE92817F9FC85B7E5ULL)),
+        "a strong pseudoprime to the primes up to 37");
+  Check(!UInt128IsPrime(Wide(0x2BE69ULL, 0x51ADC5B22410A5FDULL)),
+        "a strong pseudoprime to the primes up to 41");
+}
+
+// Checks the primes the sieve produces from start, until it passes end,
+// against testing each value.
+void CheckWideSieve(unsigned __int128 start, unsigned __int128 end,
+                    char* message) {
+  UInt128Sieve sieve;
+  UInt128SieveInit(start, &sieve);
+  unsigned __int128 value;
+  for (value = start; value <= end; value++) {
+    if (UInt128IsPrime(value)) {
+      Check(UInt128SieveNext(&sieve) == value, message);
+    }
+    if (value == end) {
+      break;
+    }
+  }
+  UInt128SieveFree(&sieve);
+}
+
+void TestWideSieve() {
+  CheckWideSieve(0, 2000000, "primes from 0");
+  CheckWideSieve(Wide(0, ~0ULL) - 100000, Wide(1, 1000000),
+                 "primes around 2^64");
+  CheckWideSieve(Wide(1000, 1), Wide(1000, 300000),
+                 "primes after 1000 * 2^64");
+
+  // The sieve stops after the largest prime below 2^128.
+  UInt128Sieve sieve;
+  unsigned __int128 start = Wide(~0ULL, ~0ULL) - 300000;
+  CheckWideSieve(start, Wide(~0ULL, ~0ULL), "primes before 2^128");
+  UInt128SieveInit(start, &sieve);
+  unsigned __int128 last = 0;
+  unsigned __int128 prime;
+  while ((prime = UInt128SieveNext(&sieve)) != 0) {
+    last = prime;
+  }
+  Check(last == Wide(~0ULL, 0xFFFFFFFFFFFFFF61ULL),
+        "the largest prime below 2^128 comes last");
+  UInt128SieveFree(&sieve);
+}
+
+int main() {
+  TestMontgomery();
+  TestSmallValues();
+  TestLargeValues();
+  TestMontgomery128();
+  TestWideValues();
+  TestWideSieve();
+  printf("All tests passed\n");
+}
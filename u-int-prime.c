@@ -0,0 +1,469 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "u-int-prime.h"
+#include "wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The largest prime below 2^64.
+#define LARGEST_PRIME 18446744073709551557ULL
+
+// The odd primes below 64, which are divided out before testing. Together
+// with 2 they leave no composite below 67 * 67 to the Miller-Rabin test.
+static const uint64_t SMALL_PRIMES[] = {
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+#define NUM_SMALL_PRIMES (sizeof(SMALL_PRIMES) / sizeof(SMALL_PRIMES[0]))
+
+// The bases found by Jim Sinclair for which every composite below 2^64
+// fails the Miller-Rabin test for at least one of them.
+static const uint64_t MILLER_RABIN_BASES[] = {
+    2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+#define NUM_MILLER_RABIN_BASES \
+    (sizeof(MILLER_RABIN_BASES) / sizeof(MILLER_RABIN_BASES[0]))
+
+// The first 25 primes, which are the Miller-Rabin bases above 2^64. The
+// first 13 of them settle every n below 3,317,044,064,679,887,385,961,981,
+// which is 0x2BE6951ADC5B22410A5FD.
+static const uint64_t WIDE_BASES[] = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67,
+    71, 73, 79, 83, 89, 97};
+#define NUM_WIDE_BASES ((int)(sizeof(WIDE_BASES) / sizeof(WIDE_BASES[0])))
+#define NUM_EXACT_WIDE_BASES 13
+#define EXACT_WIDE_BASES_BOUND \
+    ((unsigned __int128)0x2BE69ULL << 64 | 0x51ADC5B22410A5FDULL)
+
+static void ErrorOut(char* message) {
+  fprintf(stderr, "%s\n", message);
+  exit(1);
+}
+
+void MontgomeryInit(uint64_t n, Montgomery* this) {
+  if (n % 2 == 0) {
+    ErrorOut("Montgomery arithmetic needs an odd modulus.");
+  }
+  this->n_ = n;
+  // Each step doubles the number of correct low bits, and n is its own
+  // inverse modulo 8.
+  uint64_t inverse = n;
+  int i;
+  for (i = 0; i < 5; i++) {
+    inverse *= 2 - n * inverse;
+  }
+  this->n_inverse_ = inverse;
+  this->one_ = (0 - n) % n;
+  this->r_squared_ = (uint64_t)((unsigned __int128)this->one_ * this->one_ %
+                                n);
+}
+
+// Returns value / 2^64 modulo n, given value < n * 2^64. The low 64 bits of
+// m * n match those of value, so the high halves can be subtracted directly,
+// which unlike adding m * n cannot overflow when n is close to 2^64.
+static uint64_t MontgomeryReduce(const Montgomery* this,
+                                 unsigned __int128 value) {
+  uint64_t m = (uint64_t)value * this->n_inverse_;
+  uint64_t high = (uint64_t)(value >> 64);
+  uint64_t subtrahend = (uint64_t)(((unsigned __int128)m * this->n_) >> 64);
+  return high >= subtrahend ? high - subtrahend : high - subtrahend + this->n_;
+}
+
+uint64_t MontgomeryMultiply(const Montgomery* this, uint64_t a, uint64_t b) {
+  return MontgomeryReduce(this, (unsigned __int128)a * b);
+}
+
+uint64_t MontgomeryIn(const Montgomery* this, uint64_t x) {
+  return MontgomeryMultiply(this, x, this->r_squared_);
+}
+
+uint64_t MontgomeryOut(const Montgomery* this, uint64_t x) {
+  return MontgomeryReduce(this, x);
+}
+
+uint64_t MontgomeryPower(const Montgomery* this, uint64_t base,
+                         uint64_t exponent) {
+  uint64_t result = this->one_;
+  while (exponent > 0) {
+    if (exponent & 1) {
+      result = MontgomeryMultiply(this, result, base);
+    }
+    base = MontgomeryMultiply(this, base, base);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// Determines whether n, which is odd and above 2, is a strong probable prime
+// to the base, where n - 1 = odd << shift.
+static int IsStrongProbablePrime(const Montgomery* montgomery, uint64_t base,
+                                 uint64_t odd, int shift) {
+  base %= montgomery->n_;
+  if (base == 0) {
+    return 1;
+  }
+  uint64_t minus_one = montgomery->n_ - montgomery->one_;
+  uint64_t x = MontgomeryPower(montgomery, MontgomeryIn(montgomery, base),
+                               odd);
+  if (x == montgomery->one_ || x == minus_one) {
+    return 1;
+  }
+  int i;
+  for (i = 1; i < shift; i++) {
+    x = MontgomeryMultiply(montgomery, x, x);
+    if (x == minus_one) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int UIntIsPrime(uint64_t n) {
+  if (n < 2) {
+    return 0;
+  }
+  if (n % 2 == 0) {
+    return n == 2;
+  }
+  size_t i;
+  for (i = 0; i < NUM_SMALL_PRIMES; i++) {
+    if (n % SMALL_PRIMES[i] == 0) {
+      return n == SMALL_PRIMES[i];
+    }
+  }
+  if (n < 67 * 67) {
+    return 1;
+  }
+
+  Montgomery montgomery;
+  MontgomeryInit(n, &montgomery);
+  uint64_t odd = n - 1;
+  int shift = 0;
+  while (odd % 2 == 0) {
+    odd /= 2;
+    shift++;
+  }
+  for (i = 0; i < NUM_MILLER_RABIN_BASES; i++) {
+    if (!IsStrongProbablePrime(&montgomery, MILLER_RABIN_BASES[i], odd,
+                               shift)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+uint64_t UIntNextPrime(uint64_t n) {
+  int small_prime = WheelSmallPrimeAtLeast(n);
+  if (small_prime != 0) {
+    return small_prime;
+  }
+  if (n > LARGEST_PRIME) {
+    return 0;
+  }
+
+  Wheel wheel;
+  uint64_t candidate = n + WheelInit(n % WHEEL_MODULUS, &wheel);
+  while (!UIntIsPrime(candidate)) {
+    candidate += WheelNext(&wheel);
+  }
+  return candidate;
+}
+
+void Montgomery128Init(unsigned __int128 n, Montgomery128* this) {
+  if (n % 2 == 0) {
+    ErrorOut("Montgomery arithmetic needs an odd modulus.");
+  }
+  this->n_ = n;
+  unsigned __int128 inverse = n;
+  int i;
+  for (i = 0; i < 6; i++) {
+    inverse *= 2 - n * inverse;
+  }
+  this->n_inverse_ = inverse;
+  this->one_ = (0 - n) % n;
+  // Doubling 2^128 mod n another 128 times gives 2^256 mod n without a 256
+  // bit division. Each step checks against n - x, since 2 * x can overflow.
+  unsigned __int128 x = this->one_;
+  for (i = 0; i < 128; i++) {
+    x = x >= n - x ? x - (n - x) : 2 * x;
+  }
+  this->r_squared_ = x;
+}
+
+// Sets high and low to the two halves of the 256 bit product of a and b.
+static void Multiply128(unsigned __int128 a, unsigned __int128 b,
+                        unsigned __int128* high, unsigned __int128* low) {
+  uint64_t a_low = (uint64_t)a;
+  uint64_t a_high = (uint64_t)(a >> 64);
+  uint64_t b_low = (uint64_t)b;
+  uint64_t b_high = (uint64_t)(b >> 64);
+  unsigned __int128 low_low = (unsigned __int128)a_low * b_low;
+  unsigned __int128 low_high = (unsigned __int128)a_low * b_high;
+  unsigned __int128 high_low = (unsigned __int128)a_high * b_low;
+  unsigned __int128 high_high = (unsigned __int128)a_high * b_high;
+  unsigned __int128 middle = (low_low >> 64) + (uint64_t)low_high +
+                             (uint64_t)high_low;
+  *low = (middle << 64) | (uint64_t)low_low;
+  *high = high_high + (low_high >> 64) + (high_low >> 64) + (middle >> 64);
+}
+
+// Returns (high * 2^128 + low) / 2^128 modulo n, given that the value is
+// below n * 2^128, in the same way as MontgomeryReduce.
+static unsigned __int128 Montgomery128Reduce(const Montgomery128* this,
+                                             unsigned __int128 high,
+                                             unsigned __int128 low) {
+  unsigned __int128 m = low * this->n_inverse_;
+  unsigned __int128 subtrahend;
+  unsigned __int128 ignored;
+  Multiply128(m, this->n_, &subtrahend, &ignored);
+  return high >= subtrahend ? high - subtrahend
+                            : high - subtrahend + this->n_;
+}
+
+unsigned __int128 Montgomery128Multiply(const Montgomery128* this,
+                                        unsigned __int128 a,
+                                        unsigned __int128 b) {
+  unsigned __int128 high;
+  unsigned __int128 low;
+  Multiply128(a, b, &high, &low);
+  return Montgomery128Reduce(this, high, low);
+}
+
+unsigned __int128 Montgomery128In(const Montgomery128* this,
+                                  unsigned __int128 x) {
+  return Montgomery128Multiply(this, x, this->r_squared_);
+}
+
+unsigned __int128 Montgomery128Out(const Montgomery128* this,
+                                   unsigned __int128 x) {
+  return Montgomery128Reduce(this, 0, x);
+}
+
+unsigned __int128 Montgomery128Power(const Montgomery128* this,
+                                     unsigned __int128 base,
+                                     unsigned __int128 exponent) {
+  unsigned __int128 result = this->one_;
+  while (exponent > 0) {
+    if (exponent & 1) {
+      result = Montgomery128Multiply(this, result, base);
+    }
+    base = Montgomery128Multiply(this, base, base);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// The same test as IsStrongProbablePrime for n above 2^64.
+static int IsStrongProbablePrime128(const Montgomery128* montgomery,
+                                    uint64_t base, unsigned __int128 odd,
+                                    int shift) {
+  unsigned __int128 minus_one = montgomery->n_ - montgomery->one_;
+  unsigned __int128 x = Montgomery128Power(
+      montgomery, Montgomery128In(montgomery, base), odd);
+  if (x == montgomery->one_ || x == minus_one) {
+    return 1;
+  }
+  int i;
+  for (i = 1; i < shift; i++) {
+    x = Montgomery128Multiply(montgomery, x, x);
+    if (x == minus_one) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int UInt128IsPrime(unsigned __int128 n) {
+  if (n >> 64 == 0) {
+    return UIntIsPrime((uint64_t)n);
+  }
+  if (n % 2 == 0) {
+    return 0;
+  }
+  size_t i;
+  for (i = 0; i < NUM_SMALL_PRIMES; i++) {
+    if (n % SMALL_PRIMES[i] == 0) {
+      return 0;
+    }
+  }
+
+  Montgomery128 montgomery;
+  Montgomery128Init(n, &montgomery);
+  unsigned __int128 odd = n - 1;
+  int shift = 0;
+  while (odd % 2 == 0) {
+    odd /= 2;
+    shift++;
+  }
+  int num_bases = n < EXACT_WIDE_BASES_BOUND ? NUM_EXACT_WIDE_BASES
+                                             : NUM_WIDE_BASES;
+  int j;
+  for (j = 0; j < num_bases; j++) {
+    if (!IsStrongProbablePrime128(&montgomery, WIDE_BASES[j], odd, shift)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// The largest value below 2^128.
+#define U_INT_128_MAX (~(unsigned __int128)0)
+
+// Fills primes with the odd primes below U_INT_128_SIEVE_PRIME_LIMIT and
+// returns how many there are.
+static int FindSievingPrimes(uint32_t** primes) {
+  int limit = U_INT_128_SIEVE_PRIME_LIMIT;
+  char* composite = calloc(limit, 1);
+  *primes = malloc(limit / 2 * sizeof(uint32_t));
+  if (composite == NULL || *primes == NULL) {
+    ErrorOut("Unable to allocate space for the sieving primes.");
+  }
+  int num_primes = 0;
+  int i;
+  for (i = 3; i < limit; i += 2) {
+    if (!composite[i]) {
+      (*primes)[num_primes++] = i;
+      int j;
+      for (j = 3 * i; j < limit; j += 2 * i) {
+        composite[j] = 1;
+      }
+    }
+  }
+  free(composite);
+  return num_primes;
+}
+
+// Finds the bit index, from low, of the first odd multiple of p which is at
+// least both low and p * p.
+static uint64_t FirstOffset(uint32_t p, unsigned __int128 low) {
+  unsigned __int128 square = (uint64_t)p * p;
+  if (low <= square) {
+    return (uint64_t)((square - low) / 2);
+  }
+  uint64_t remainder = (uint64_t)(low % p);
+  uint64_t distance = remainder == 0 ? 0 : p - remainder;
+  if (distance % 2 == 1) {
+    // low is odd, so this multiple is even.
+    distance += p;
+  }
+  return distance / 2;
+}
+
+// Finds the first set bit at or after from, or returns -1 if there is none.
+static int NextSetBit(const uint64_t* words, int bits, int from) {
+  int num_words = (bits + 63) / 64;
+  int word_index = from / 64;
+  if (word_index >= num_words) {
+    return -1;
+  }
+  uint64_t word = words[word_index] >> (from % 64);
+  if (word != 0) {
+    return from + __builtin_ctzll(word);
+  }
+  for (word_index++; word_index < num_words; word_index++) {
+    if (words[word_index] != 0) {
+      return 64 * word_index + __builtin_ctzll(words[word_index]);
+    }
+  }
+  return -1;
+}
+
+// Moves on to the next segment and sieves it. Returns 0 if the previous
+// segment already reached the end of the 128 bit range.
+static int SieveNextWideSegment(UInt128Sieve* this) {
+  if (this->last_segment_) {
+    return 0;
+  }
+  if (this->segment_bits_ > 0) {
+    this->low_ += 2 * (unsigned __int128)this->segment_bits_;
+  }
+
+  int bits = 8 * U_INT_128_SIEVE_SEGMENT_BYTES;
+  if ((U_INT_128_MAX - this->low_) / 2 < (unsigned __int128)(bits - 1)) {
+    bits = (int)((U_INT_128_MAX - this->low_) / 2 + 1);
+    this->last_segment_ = 1;
+  }
+  memset(this->segment_, 0xFF, U_INT_128_SIEVE_SEGMENT_BYTES);
+  if (bits % 64 != 0) {
+    // Only the last segment is cut short, and its final word is too.
+    this->segment_[bits / 64] = ((uint64_t)1 << (bits % 64)) - 1;
+  }
+  int i;
+  for (i = 0; i < this->num_primes_; i++) {
+    uint32_t p = this->primes_[i];
+    uint64_t offset = this->offsets_[i];
+    for (; offset < (uint64_t)bits; offset += p) {
+      this->segment_[offset / 64] &= ~((uint64_t)1 << (offset % 64));
+    }
+    this->offsets_[i] = offset - bits;
+  }
+
+  this->segment_bits_ = bits;
+  this->next_bit_ = 0;
+  return 1;
+}
+
+void UInt128SieveInit(unsigned __int128 start, UInt128Sieve* this) {
+  this->low_ = start | 1;
+  this->segment_ = malloc(U_INT_128_SIEVE_SEGMENT_BYTES);
+  if (this->segment_ == NULL) {
+    ErrorOut("Unable to allocate space for a sieve segment.");
+  }
+  this->segment_bits_ = 0;
+  this->next_bit_ = 0;
+  this->last_segment_ = 0;
+  this->reported_two_ = start > 2;
+  this->num_primes_ = FindSievingPrimes(&this->primes_);
+  this->offsets_ = malloc(this->num_primes_ * sizeof(uint64_t));
+  if (this->offsets_ == NULL) {
+    ErrorOut("Unable to allocate space for the sieve offsets.");
+  }
+  int i;
+  for (i = 0; i < this->num_primes_; i++) {
+    this->offsets_[i] = FirstOffset(this->primes_[i], this->low_);
+  }
+}
+
+void UInt128SieveFree(UInt128Sieve* this) {
+  free(this->segment_);
+  free(this->primes_);
+  free(this->offsets_);
+  this->segment_ = NULL;
+  this->primes_ = NULL;
+  this->offsets_ = NULL;
+}
+
+unsigned __int128 UInt128SieveNext(UInt128Sieve* this) {
+  if (!this->reported_two_) {
+    this->reported_two_ = 1;
+    return 2;
+  }
+
+  while (1) {
+    int bit;
+    while ((bit = NextSetBit(this->segment_, this->segment_bits_,
+                             this->next_bit_)) >= 0) {
+      this->next_bit_ = bit + 1;
+      unsigned __int128 value = this->low_ + 2 * (unsigned __int128)bit;
+      if (UInt128IsPrime(value)) {
+        return value;
+      }
+    }
+    if (!SieveNextWideSegment(this)) {
+      return 0;
+    }
+  }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef U_INT_PRIME_H
+#define U_INT_PRIME_H
+
+#include <stdint.h>
+
+// Arithmetic modulo an odd n below 2^64 with values kept in Montgomery form,
+// x * 2^64 mod n. A product in that form is reduced with two multiplications
+// and a subtraction rather than a 128 bit division, which is what makes
+// modular exponentiation cheap enough to test every candidate.
+typedef struct {
+  uint64_t n_;
+  uint64_t n_inverse_;  // n * n_inverse_ == 1 modulo 2^64.
+  uint64_t r_squared_;  // 2^128 mod n, which moves values into the form.
+  uint64_t one_;  // 1 in Montgomery form, which is 2^64 mod n.
+} Montgomery;
+
+// Prepares arithmetic modulo n, which must be odd.
+void MontgomeryInit(uint64_t n, Montgomery* this);
+
+// Converts a value below n into Montgomery form and back.
+uint64_t MontgomeryIn(const Montgomery* this, uint64_t x);
+uint64_t MontgomeryOut(const Montgomery* this, uint64_t x);
+
+// Multiplies two values in Montgomery form, giving the product in the form.
+uint64_t MontgomeryMultiply(const Montgomery* this, uint64_t a, uint64_t b);
+
+// Raises a value in Montgomery form to the exponent, giving the power in the
+// form.
+uint64_t MontgomeryPower(const Montgomery* this, uint64_t base,
+                         uint64_t exponent);
+
+// Determines whether n is prime. Values with a factor below 64 are settled
+// by division and every other value by a Miller-Rabin test to the bases 2,
+// 325, 9375, 28178, 450775, 9780504 and 1795265022, which no composite below
+// 2^64 passes, so the answer is never a guess.
+int UIntIsPrime(uint64_t n);
+
+// Provides the smallest prime which is at least n, stepping the candidates
+// along the mod 210 wheel. Returns 0 if there is no such prime below 2^64.
+uint64_t UIntNextPrime(uint64_t n);
+
+// Montgomery arithmetic modulo an odd n below 2^128, with values kept in the
+// form x * 2^128 mod n. Products take 256 bits, which are built from four
+// 64 by 64 bit multiplications.
+typedef struct {
+  unsigned __int128 n_;
+  unsigned __int128 n_inverse_;  // n * n_inverse_ == 1 modulo 2^128.
+  unsigned __int128 r_squared_;  // 2^256 mod n.
+  unsigned __int128 one_;  // 2^128 mod n.
+} Montgomery128;
+
+// The same operations as for Montgomery, for moduli up to 2^128.
+void Montgomery128Init(unsigned __int128 n, Montgomery128* this);
+unsigned __int128 Montgomery128In(const Montgomery128* this,
+                                  unsigned __int128 x);
+unsigned __int128 Montgomery128Out(const Montgomery128* this,
+                                   unsigned __int128 x);
+unsigned __int128 Montgomery128Multiply(const Montgomery128* this,
+                                        unsigned __int128 a,
+                                        unsigned __int128 b);
+unsigned __int128 Montgomery128Power(const Montgomery128* this,
+                                     unsigned __int128 base,
+                                     unsigned __int128 exponent);
+
+// Determines whether n is prime. Values below 2^64 go to UIntIsPrime. Above
+// that, a Miller-Rabin test to the first 13 primes is exact below
+// 3,317,044,064,679,887,385,961,981 (Sorenson and Webster, 2015), and
+// larger values are tested to the first 25 primes, so a result of 1 there
+// means a probable prime.
+int UInt128IsPrime(unsigned __int128 n);
+
+// The bytes in each segment of a UInt128Sieve, which fit in the L1 data
+// cache.
+#define U_INT_128_SIEVE_SEGMENT_BYTES 32768
+
+// The segments of a UInt128Sieve are sieved by the odd primes below this.
+#define U_INT_128_SIEVE_PRIME_LIMIT (1 << 20)
+
+// Produces the primes from a starting point up through the end of the 128
+// bit range, in order.
+//
+// Past 2^64 a table of every sieving prime up to the square root is out of
+// reach, so segments of odd values are only sieved by the primes below
+// U_INT_128_SIEVE_PRIME_LIMIT. That leaves about one odd value in twelve, and
+// each of those is checked with UInt128IsPrime. Every sieving prime hits
+// every segment, so each keeps the bit index of its next odd multiple, which
+// carries over from one segment to the next.
+//
+// A UInt128Sieve must be set up with UInt128SieveInit and released with
+// UInt128SieveFree.
+typedef struct {
+  unsigned __int128 low_;  // The odd value of bit 0 in the current segment.
+  uint64_t* segment_;
+  int segment_bits_;  // The number of bits in use in the current segment.
+  int next_bit_;  // Where to resume scanning the current segment.
+  int last_segment_;  // Set once the segment reaching 2^128 - 1 is sieved.
+  int reported_two_;
+  uint32_t* primes_;
+  uint64_t* offsets_;  // The next odd multiple of each prime, as a bit index.
+  int num_primes_;
+} UInt128Sieve;
+
+// Prepares the sieve to produce primes starting with the smallest prime
+// which is at least start.
+void UInt128SieveInit(unsigned __int128 start, UInt128Sieve* this);
+
+// Releases the memory held by the sieve.
+void UInt128SieveFree(UInt128Sieve* this);
+
+// Provides the next prime in increasing order. Returns 0 once every prime
+// below 2^128 has been produced.
+unsigned __int128 UInt128SieveNext(UInt128Sieve* this);
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void Check(int condition, char* message) {
+  if (!condition) {
+    fprintf(stderr, "Condition failed: %s\n", message);
+    exit(1);
+  }
+}
+
+int IsCoprimeTo210(uint64_t value) {
+  return value % 2 != 0 && value % 3 != 0 && value % 5 != 0 && value % 7 != 0;
+}
+
+void TestSteps() {
+  Wheel wheel;
+  uint64_t value = WheelInit(0, &wheel);
+  Check(value == 1, "the wheel starts at 1");
+  uint64_t n;
+  for (n = 2; n < 100000; n++) {
+    if (IsCoprimeTo210(n)) {
+      value += WheelNext(&wheel);
+      Check(value == n, "the wheel stops on each coprime value");
+    }
+  }
+
+  Check(WheelInit(11, &wheel) == 0, "11 is on the wheel");
+  Check(WheelNext(&wheel) == 2, "13 follows 11");
+  Check(WheelInit(209, &wheel) == 0, "209 is on the wheel");
+  Check(WheelNext(&wheel) == 2, "211 follows 209");
+  Check(WheelNext(&wheel) == 10, "221 follows 211");
+}
+
+void TestInit() {
+  // Starting anywhere gives the next coprime value at or above it.
+  uint64_t start;
+  for (start = 1000; start < 1000 + 2 * WHEEL_MODULUS; start++) {
+    Wheel wheel;
+    uint64_t value = start + WheelInit(start % WHEEL_MODULUS, &wheel);
+    Check(value >= start && IsCoprimeTo210(value), "init lands on the wheel");
+    uint64_t n;
+    for (n = start; n < value; n++) {
+      Check(!IsCoprimeTo210(n), "init does not skip a coprime value");
+    }
+    value += WheelNext(&wheel);
+    Check(IsCoprimeTo210(value), "the step after init stays on the wheel");
+  }
+}
+
+void TestSmallPrimes() {
+  Check(WheelSmallPrimeAtLeast(0) == 2, "2 is the first small prime");
+  Check(WheelSmallPrimeAtLeast(3) == 3, "3 is a small prime");
+  Check(WheelSmallPrimeAtLeast(4) == 5, "5 follows 4");
+  Check(WheelSmallPrimeAtLeast(6) == 7, "7 follows 6");
+  Check(WheelSmallPrimeAtLeast(8) == 0, "the wheel takes over after 7");
+}
+
+int main() {
+  TestSteps();
+  TestInit();
+  TestSmallPrimes();
+  printf("All tests passed\n");
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// The residues modulo 210 which have none of 2, 3, 5 or 7 as a factor.
+static const uint8_t WHEEL_RESIDUES[WHEEL_SIZE] = {
+    1, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67,
+    71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 121, 127, 131, 137, 139,
+    143, 149, 151, 157, 163, 167, 169, 173, 179, 181, 187, 191, 193, 197, 199,
+    209};
+
+// The distance from each residue to the next, wrapping around from 209 to
+// 211.
+static const uint8_t WHEEL_GAPS[WHEEL_SIZE] = {
+    10, 2, 4, 2, 4, 6, 2, 6, 4, 2, 4, 6, 6, 2, 6, 4,
+    2, 6, 4, 6, 8, 4, 2, 4, 2, 4, 8, 6, 4, 6, 2, 4,
+    6, 2, 6, 6, 4, 2, 4, 6, 2, 6, 4, 2, 4, 2, 10, 2};
+
+static void ErrorOut(char* message) {
+  fprintf(stderr, "%s\n", message);
+  exit(1);
+}
+
+int WheelInit(int residue, Wheel* this) {
+  if (residue < 0 || residue >= WHEEL_MODULUS) {
+    ErrorOut("Wheel residues must be from 0 to 209.");
+  }
+  int i;
+  for (i = 0; WHEEL_RESIDUES[i] < residue; i++) {
+  }
+  this->index_ = i;
+  return WHEEL_RESIDUES[i] - residue;
+}
+
+int WheelNext(Wheel* this) {
+  int gap = WHEEL_GAPS[this->index_];
+  this->index_++;
+  if (this->index_ == WHEEL_SIZE) {
+    this->index_ = 0;
+  }
+  return gap;
+}
+
+int WheelSmallPrimeAtLeast(uint64_t value) {
+  if (value <= 2) {
+    return 2;
+  } else if (value <= 3) {
+    return 3;
+  } else if (value <= 5) {
+    return 5;
+  } else if (value <= 7) {
+    return 7;
+  }
+  return 0;
+}
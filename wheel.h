@@ -0,0 +1,54 @@
+/*
+ * Copyright 2014 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdint.h>
+
+// The product of the primes the wheel skips: 2, 3, 5 and 7.
+#define WHEEL_MODULUS 210
+
+// The number of values below WHEEL_MODULUS which have none of 2, 3, 5 or 7
+// as a factor.
+#define WHEEL_SIZE 48
+
+// Steps through the values which have none of 2, 3, 5 or 7 as a factor, in
+// increasing order. That is 48 of every 210 values, so trial division which
+// steps its candidates and divisors with a wheel skips about 77% of them
+// where stepping over even values only skips 50%.
+//
+// The wheel only tracks where it is among the residues modulo 210, so it
+// works with whatever type holds the values: each step returns how much to
+// add to the current value to reach the next one.
+typedef struct {
+  int index_;  // The current value's position among the coprime residues.
+} Wheel;
+
+// Positions the wheel at the smallest value, at least as large as a value
+// whose remainder modulo 210 is residue, which has none of 2, 3, 5 or 7 as a
+// factor. Returns how much to add to the value to get there.
+int WheelInit(int residue, Wheel* this);
+
+// Moves the wheel to the next value and returns how much to add to get to
+// it.
+int WheelNext(Wheel* this);
+
+// The wheel never stops on 2, 3, 5 or 7 themselves. Provides the smallest of
+// them which is at least value, or 0 if value is more than 7.
+int WheelSmallPrimeAtLeast(uint64_t value);
+
+#endif